@@ -20,7 +20,7 @@ public class GEPhase : ModuleRules
         PublicDependencyModuleNames.AddRange(
             new string[]
             {
-                "Core", "CoreUObject", "Engine",
+                "Core", "CoreUObject", "Engine", "DeveloperSettings",
 
                 "GameplayTags", 
                 
@@ -32,7 +32,7 @@ public class GEPhase : ModuleRules
         PrivateDependencyModuleNames.AddRange(
             new string[]
             {
-                "GameFeatures", "ModularGameplay", "GameplayTasks", "NetCore",
+                "GameFeatures", "ModularGameplay", "GameplayTasks", "NetCore", "AssetRegistry",
             }
         );
     }
@@ -9,17 +9,7 @@ void UAsyncAction_ListenForGamePhase::Activate()
 {
 	if (auto* Subsystem{ UWorld::GetSubsystem<UGamePhaseSubsystem>(WorldPtr.Get()) })
 	{
-		auto WeakThis{ TWeakObjectPtr<UAsyncAction_ListenForGamePhase>(this) };
-
-		ListenerHandle = Subsystem->RegisterListener(ChannelToRegister,
-			[WeakThis](FGameplayTag GamePhaseTag, EGamePhaseEventType EventType)
-			{
-				if (auto* StrongThis{ WeakThis.Get() })
-				{
-					StrongThis->HandleEventReceived(GamePhaseTag, EventType);
-				}
-			},
-			TagMatchType);
+		ListenerHandle = Subsystem->RegisterListener(ChannelToRegister, this, &ThisClass::HandleEventReceived, TagMatchType, bReplayActivePhases, ListenerPriority);
 	}
 	else
 	{
@@ -34,7 +24,7 @@ void UAsyncAction_ListenForGamePhase::SetReadyToDestroy()
 	Super::SetReadyToDestroy();
 }
 
-UAsyncAction_ListenForGamePhase* UAsyncAction_ListenForGamePhase::ListenForGamePhase(UObject* WorldContextObject, FGameplayTag GamePhaseTag, EGamePhaseTagMatchType MatchType)
+UAsyncAction_ListenForGamePhase* UAsyncAction_ListenForGamePhase::ListenForGamePhase(UObject* WorldContextObject, FGameplayTag GamePhaseTag, EGamePhaseTagMatchType MatchType, bool bReplayActivePhases, EGamePhaseListenerPriority Priority)
 {
 	auto* World{ GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) };
 	if (!World)
@@ -46,6 +36,8 @@ UAsyncAction_ListenForGamePhase* UAsyncAction_ListenForGamePhase::ListenForGameP
 	Action->WorldPtr = World;
 	Action->ChannelToRegister = GamePhaseTag;
 	Action->TagMatchType = MatchType;
+	Action->bReplayActivePhases = bReplayActivePhases;
+	Action->ListenerPriority = Priority;
 	//Action->RegisterWithGameInstance(World);
 
 	return Action;
@@ -37,6 +37,8 @@ protected:
 	TWeakObjectPtr<UWorld> WorldPtr;
 	FGameplayTag ChannelToRegister;
 	EGamePhaseTagMatchType TagMatchType{ EGamePhaseTagMatchType::ExactMatch };
+	bool bReplayActivePhases{ false };
+	EGamePhaseListenerPriority ListenerPriority{ EGamePhaseListenerPriority::Default };
 
 	FGamePhaseListenerHandle ListenerHandle;
 
@@ -49,9 +51,11 @@ public:
 	 *
 	 * @param GamePhaseTag		The game phase to listen for
 	 * @param MatchType			The rule used for matching the game phase tag with broadcasted event
+	 * @param bReplayActivePhases	If true, Start is received right away for the already active game phases that match
+	 * @param Priority			Ordering group in which this listener receives events
 	 */
 	UFUNCTION(BlueprintCallable, Category = "GamePhase", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true"))
-	static UAsyncAction_ListenForGamePhase* ListenForGamePhase(UObject* WorldContextObject, UPARAM(meta = (Categories = "GamePhase")) FGameplayTag GamePhaseTag, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch);
+	static UAsyncAction_ListenForGamePhase* ListenForGamePhase(UObject* WorldContextObject, UPARAM(meta = (Categories = "GamePhase")) FGameplayTag GamePhaseTag, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch, bool bReplayActivePhases = false, EGamePhaseListenerPriority Priority = EGamePhaseListenerPriority::Default);
 
 private:
 	void HandleEventReceived(FGameplayTag GamePhaseTag, EGamePhaseEventType EventType);
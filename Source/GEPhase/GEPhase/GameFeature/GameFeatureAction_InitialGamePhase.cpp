@@ -126,11 +126,16 @@ void UGameFeatureAction_InitialGamePhase::SetInitialGamePhase(AGameStateBase* Ga
 	{
 		if (auto* Component{ GameState->FindComponentByClass<UGamePhaseComponent>() })
 		{
-			Component->SetGamePhase(InitialGamePhase);
+			// Wait for the game phase from the game mode option, which sends the ready event again if it could not be set
+
+			if (!Component->IsGameModeOptionPending())
+			{
+				Component->SetGamePhase(InitialGamePhase);
+			}
 		}
 	}
 
-	ActiveData.GameStateToAdded.Add(GameState);
+	ActiveData.GameStateToAdded.AddUnique(GameState);
 }
 
 void UGameFeatureAction_InitialGamePhase::RemoveContextData(AGameStateBase* GameState, FPerContextData& ActiveData)
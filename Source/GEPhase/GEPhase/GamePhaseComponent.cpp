@@ -2,7 +2,12 @@
 
 #include "GamePhaseComponent.h"
 
+#include "Phase/GamePhase.h"
 #include "GEPhaseLogs.h"
+#include "GEPhaseStats.h"
+#include "Setting/GEPhaseDeveloperSettings.h"
+#include "Graph/GamePhaseGraph.h"
+#include "Registry/GamePhaseClassRegistry.h"
 
 #include "InitState/InitStateTags.h"
 #include "InitState/InitStateComponent.h"
@@ -12,11 +17,20 @@
 #include "Net/Core/PushModel/PushModel.h"
 #include "Components/GameFrameworkComponentManager.h"
 #include "GameFramework/GameStateBase.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/GameSession.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/AssetManager.h"
+#include "TimerManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GamePhaseComponent)
 
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Hits"), STAT_GamePhase_NumPoolHits, STATGROUP_GamePhase);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Misses"), STAT_GamePhase_NumPoolMisses, STATGROUP_GamePhase);
+
+
 const FName UGamePhaseComponent::NAME_ActorFeatureName("GamePhase");
 
 const FName UGamePhaseComponent::NAME_GamePhaseReady("GamePhaseReady");
@@ -25,7 +39,7 @@ UGamePhaseComponent::UGamePhaseComponent(const FObjectInitializer& ObjectInitial
 	: Super(ObjectInitializer)
 {
 	PrimaryComponentTick.bStartWithTickEnabled = false;
-	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bCanEverTick = true;
 
 	SetIsReplicatedByDefault(true);
 }
@@ -39,6 +53,7 @@ void UGamePhaseComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>&
 	Params.Condition = COND_None;
 
 	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, ActiveGamePhases, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, GamePhaseGraph, Params);
 }
 
 
@@ -73,6 +88,13 @@ void UGamePhaseComponent::BeginPlay()
 
 	BindOnActorInitStateChanged(NAME_None, FGameplayTag(), false);
 
+	// Check the class registry of each player that joins
+
+	if (HasAuthority())
+	{
+		PostLoginHandle = FGameModeEvents::GameModePostLoginEvent.AddUObject(this, &ThisClass::HandlePlayerPostLogin);
+	}
+
 	// Change the initialization state of this component to [Spawned]
 
 	ensureMsgf(TryToChangeInitState(TAG_InitState_Spawned), TEXT("[%s] on [%s]."), *GetNameSafe(this), *GetNameSafe(GetOwner()));
@@ -86,6 +108,41 @@ void UGamePhaseComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	UnregisterInitStateFeature();
 
+	TickBuckets.Empty();
+
+	TimerWheel.Empty();
+	ExpiryTimerIds.Empty();
+
+	GetWorld()->GetTimerManager().ClearTimer(PredictionTimeoutTimerHandle);
+	GetWorld()->GetTimerManager().ClearTimer(PrefetchReleaseTimerHandle);
+
+	EmptyInstancePools();
+
+	for (auto& KVP : Prefetches)
+	{
+		if (KVP.Value.ClassHandle.IsValid())
+		{
+			KVP.Value.ClassHandle->CancelHandle();
+		}
+
+		if (KVP.Value.AssetsHandle.IsValid())
+		{
+			KVP.Value.AssetsHandle->CancelHandle();
+		}
+	}
+
+	Prefetches.Empty();
+
+	for (const auto& Handle : ReplicatedClassHandles)
+	{
+		Handle->CancelHandle();
+	}
+
+	ReplicatedClassHandles.Empty();
+
+	FGameModeEvents::GameModePostLoginEvent.Remove(PostLoginHandle);
+	PostLoginHandle.Reset();
+
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -208,24 +265,39 @@ void UGamePhaseComponent::CheckDefaultInitialization()
 }
 
 
-bool UGamePhaseComponent::SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass)
+void UGamePhaseComponent::MarkActiveGamePhasesDirty()
+{
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ActiveGamePhases, this);
+}
+
+bool UGamePhaseComponent::SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass, float Duration)
 {
 	if (!HasAuthority())
 	{
 		return false;
 	}
 
-	return ActiveGamePhases.SetGamePhase(GamePhaseClass);
+	if (IsInGamePhaseTransaction())
+	{
+		return RecordTransactionOp(FGamePhaseTransactionOp(EGamePhaseTransactionOpType::SetGamePhase, GamePhaseClass, FGameplayTag::EmptyTag, Duration));
+	}
+
+	return ActiveGamePhases.SetGamePhase(GamePhaseClass, Duration);
 }
 
-bool UGamePhaseComponent::AddSubPhase(TSubclassOf<UGamePhase> GamePhaseClass, FGameplayTag InParentPhaseTag)
+bool UGamePhaseComponent::AddSubPhase(TSubclassOf<UGamePhase> GamePhaseClass, FGameplayTag InParentPhaseTag, float Duration)
 {
 	if (!HasAuthority())
 	{
 		return false;
 	}
 
-	return ActiveGamePhases.AddSubPhase(GamePhaseClass, InParentPhaseTag);
+	if (IsInGamePhaseTransaction())
+	{
+		return RecordTransactionOp(FGamePhaseTransactionOp(EGamePhaseTransactionOpType::AddSubPhase, GamePhaseClass, InParentPhaseTag, Duration));
+	}
+
+	return ActiveGamePhases.AddSubPhase(GamePhaseClass, InParentPhaseTag, Duration);
 }
 
 bool UGamePhaseComponent::EndPhaseByTag(FGameplayTag InGamePhaseTag)
@@ -235,72 +307,1044 @@ bool UGamePhaseComponent::EndPhaseByTag(FGameplayTag InGamePhaseTag)
 		return false;
 	}
 
+	if (IsInGamePhaseTransaction())
+	{
+		return RecordTransactionOp(FGamePhaseTransactionOp(EGamePhaseTransactionOpType::EndPhase, nullptr, InGamePhaseTag, 0.0f));
+	}
+
 	return ActiveGamePhases.EndPhaseByTag(InGamePhaseTag);
 }
 
+bool UGamePhaseComponent::EndAllGamePhases()
+{
+	if (!HasAuthority())
+	{
+		return false;
+	}
+
+	if (IsInGamePhaseTransaction())
+	{
+		return RecordTransactionOp(FGamePhaseTransactionOp(EGamePhaseTransactionOpType::EndAllPhases, nullptr, FGameplayTag::EmptyTag, 0.0f));
+	}
+
+	return ActiveGamePhases.EndAllGamePhases();
+}
+
+void UGamePhaseComponent::RefreshGamePhaseRelevancy()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	ActiveGamePhases.RefreshRelevancy();
+}
+
 TSubclassOf<UGamePhase> UGamePhaseComponent::GetCurrentGamePhaseClass() const
 {
 	return ActiveGamePhases.GetCurrentGamePhaseClass();
 }
 
+UGamePhase* UGamePhaseComponent::FindGamePhaseByTag(FGameplayTag InGamePhaseTag) const
+{
+	return ActiveGamePhases.FindGamePhaseByTag(InGamePhaseTag);
+}
+
+FGameplayTag UGamePhaseComponent::GetParentPhaseTag(FGameplayTag InGamePhaseTag) const
+{
+	return ActiveGamePhases.GetParentPhaseTag(InGamePhaseTag);
+}
 
-// Game Mode Option
 
-bool UGamePhaseComponent::InitializeFromGameModeOption()
+// Transaction
+
+void UGamePhaseComponent::BeginGamePhaseTransaction()
 {
 	if (!HasAuthority())
+	{
+		return;
+	}
+
+	if (TransactionDepth++ == 0)
+	{
+		bTransactionCancelled = false;
+		TransactionOps.Reset();
+	}
+}
+
+bool UGamePhaseComponent::CommitGamePhaseTransaction()
+{
+	if (!ensureMsgf(TransactionDepth > 0, TEXT("CommitGamePhaseTransaction called without a transaction in progress.")))
 	{
 		return false;
 	}
 
-	auto* GameMode{ GetWorld()->GetAuthGameMode() };
-	if (ensure(GameMode))
+	// Inner transactions are applied with the outermost one
+
+	if (--TransactionDepth > 0)
 	{
-		auto OptionString{ GameMode->OptionsString };
+		return !bTransactionCancelled;
+	}
 
-		UE_LOG(LogGameExt_GamePhase, Log, TEXT("Initialize Game Phase From Game Mode Option"));
+	// Take out the changes first since they may start another transaction
 
-		if (UGameplayStatics::HasOption(OptionString, UGamePhaseComponent::NAME_GamePhaseOptionKey))
+	auto Ops{ MoveTemp(TransactionOps) };
+	TransactionOps.Reset();
+
+	if (bTransactionCancelled)
+	{
+		bTransactionCancelled = false;
+		return false;
+	}
+
+	const auto bApplied{ ActiveGamePhases.ApplyTransaction(Ops) };
+
+	if (!bApplied)
+	{
+		UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Game phase transaction was rejected since some of the changes are no longer valid."));
+	}
+
+	return bApplied;
+}
+
+void UGamePhaseComponent::CancelGamePhaseTransaction()
+{
+	if (!ensureMsgf(TransactionDepth > 0, TEXT("CancelGamePhaseTransaction called without a transaction in progress.")))
+	{
+		return;
+	}
+
+	bTransactionCancelled = true;
+
+	CommitGamePhaseTransaction();
+}
+
+bool UGamePhaseComponent::RecordTransactionOp(FGamePhaseTransactionOp&& Op)
+{
+	// Record only if valid after the changes recorded so far
+
+	TransactionOps.Add(MoveTemp(Op));
+
+	if (!ActiveGamePhases.ValidateTransaction(TransactionOps))
+	{
+		TransactionOps.Pop();
+		return false;
+	}
+
+	return true;
+}
+
+
+// Prediction
+
+bool UGamePhaseComponent::PredictSubPhase(TSubclassOf<UGamePhase> GamePhaseClass, FGameplayTag InParentPhaseTag, float Duration)
+{
+	if (HasAuthority())
+	{
+		return AddSubPhase(GamePhaseClass, InParentPhaseTag, Duration);
+	}
+
+	if (!ActiveGamePhases.PredictSubPhase(GamePhaseClass, InParentPhaseTag, Duration))
+	{
+		return false;
+	}
+
+	if (!GetWorld()->GetTimerManager().IsTimerActive(PredictionTimeoutTimerHandle))
+	{
+		SchedulePredictionTimeout(GetWorld()->GetTimeSeconds());
+	}
+
+	return true;
+}
+
+bool UGamePhaseComponent::IsGamePhasePredicted(FGameplayTag InGamePhaseTag) const
+{
+	return ActiveGamePhases.IsGamePhasePredicted(InGamePhaseTag);
+}
+
+void UGamePhaseComponent::SchedulePredictionTimeout(double OldestPredictionTime)
+{
+	const auto Timeout{ GetDefault<UGEPhaseDeveloperSettings>()->PredictionTimeout };
+	const auto Delay{ FMath::Max(OldestPredictionTime + Timeout - GetWorld()->GetTimeSeconds(), UE_KINDA_SMALL_NUMBER) };
+
+	GetWorld()->GetTimerManager().SetTimer(PredictionTimeoutTimerHandle, this, &ThisClass::HandlePredictionTimeout, static_cast<float>(Delay), false);
+}
+
+void UGamePhaseComponent::HandlePredictionTimeout()
+{
+	const auto Timeout{ GetDefault<UGEPhaseDeveloperSettings>()->PredictionTimeout };
+	const auto OldestPredictionTime{ ActiveGamePhases.RollbackExpiredPredictions(GetWorld()->GetTimeSeconds() - Timeout) };
+
+	if (OldestPredictionTime >= 0.0)
+	{
+		SchedulePredictionTimeout(OldestPredictionTime);
+	}
+}
+
+
+// Instance Pool
+
+UGamePhase* UGamePhaseComponent::AcquireGamePhaseInstance(const TSubclassOf<UGamePhase>& GamePhaseClass)
+{
+	check(GamePhaseClass);
+
+	const auto bPoolInstances{ GamePhaseClass.GetDefaultObject()->ShouldPoolInstances() };
+
+	if (bPoolInstances)
+	{
+		if (auto* Pool{ InstancePools.Find(GamePhaseClass) }; Pool && !Pool->Instances.IsEmpty())
 		{
-			const auto PhaseClassPathFromOptions{ UGameplayStatics::ParseOption(OptionString, UGamePhaseComponent::NAME_GamePhaseOptionKey) };
-			const auto PhaseClassPath{ FSoftClassPath(PhaseClassPathFromOptions) };
+			++NumPoolHits;
+			INC_DWORD_STAT(STAT_GamePhase_NumPoolHits);
 
-			UE_LOG(LogGameExt_GamePhase, Log, TEXT("| OptionValue: %s"), *PhaseClassPathFromOptions);
-			UE_LOG(LogGameExt_GamePhase, Log, TEXT("| PhaseClass: %s"), *PhaseClassPath.ToString());
+			return Pool->Instances.Pop();
+		}
+
+		++NumPoolMisses;
+		INC_DWORD_STAT(STAT_GamePhase_NumPoolMisses);
+	}
+
+	return NewObject<UGamePhase>(GetOwner(), GamePhaseClass);
+}
+
+void UGamePhaseComponent::ReleaseGamePhaseInstance(UGamePhase* Instance)
+{
+	if (!Instance || !Instance->ShouldPoolInstances())
+	{
+		return;
+	}
+
+	Instance->ResetGamePhase();
+
+	InstancePools.FindOrAdd(Instance->GetClass()).Instances.Add(Instance);
+}
+
+void UGamePhaseComponent::EmptyInstancePools()
+{
+	InstancePools.Empty();
+}
+
+
+// Game Phase Tick
+
+void UGamePhaseComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AdvanceTimerWheel();
+
+	TickGamePhases(DeltaTime);
+}
+
+bool UGamePhaseComponent::GetShouldTick() const
+{
+	return Super::GetShouldTick() || !TickBuckets.IsEmpty() || !ExpiryTimerIds.IsEmpty();
+}
+
+void UGamePhaseComponent::AddTickingGamePhase(UGamePhase* GamePhase)
+{
+	check(GamePhase);
+
+	const auto Interval{ FMath::Max(GamePhase->GetTickInterval(), 0.0f) };
 
-			if (auto* PhaseClass{ PhaseClassPath.TryLoadClass<UGamePhase>() })
+	auto* Bucket
+	{
+		TickBuckets.FindByPredicate(
+			[Interval](const FGamePhaseTickBucket& Each)
 			{
-				return SetGamePhase(PhaseClass);
+				return FMath::IsNearlyEqual(Each.Interval, Interval);
 			}
+		)
+	};
+
+	if (!Bucket)
+	{
+		Bucket = &TickBuckets.AddDefaulted_GetRef();
+		Bucket->Interval = Interval;
+	}
+
+	Bucket->GamePhases.AddUnique(GamePhase);
+
+	UpdateShouldTick();
+}
+
+void UGamePhaseComponent::RemoveTickingGamePhase(UGamePhase* GamePhase)
+{
+	for (auto BucketIdx{ TickBuckets.Num() - 1 }; BucketIdx >= 0; --BucketIdx)
+	{
+		auto& Bucket{ TickBuckets[BucketIdx] };
+
+		const auto Index{ Bucket.GamePhases.Find(GamePhase) };
+
+		if (Index == INDEX_NONE)
+		{
+			continue;
+		}
+
+		// Leave a null while ticking so that the iteration is not disturbed
+
+		if (bTickingGamePhases)
+		{
+			Bucket.GamePhases[Index] = nullptr;
+			Bucket.bNeedsCompaction = true;
 		}
 		else
 		{
-			UE_LOG(LogGameExt_GamePhase, Log, TEXT("| No Game Mode Option"));
+			Bucket.GamePhases.RemoveAtSwap(Index);
+
+			if (Bucket.GamePhases.IsEmpty())
+			{
+				TickBuckets.RemoveAtSwap(BucketIdx);
+			}
 		}
+
+		break;
 	}
 
-	return false;
+	if (!bTickingGamePhases)
+	{
+		UpdateShouldTick();
+	}
 }
 
-FString UGamePhaseComponent::ConstructGameModeOption() const
+void UGamePhaseComponent::TickGamePhases(float DeltaTime)
 {
-	auto PhaseClass{ GetCurrentGamePhaseClass() };
+	if (TickBuckets.IsEmpty())
+	{
+		return;
+	}
 
-	if (PhaseClass)
+	TGuardValue<bool> TickingGuard{ bTickingGamePhases, true };
+
+	for (auto BucketIdx{ 0 }; BucketIdx < TickBuckets.Num(); ++BucketIdx)
 	{
-		FSoftClassPath Path{ PhaseClass };
-		return FString::Printf(TEXT("?%s=%s"), *UGamePhaseComponent::NAME_GamePhaseOptionKey, *Path.GetAssetPathString());
+		// Each bucket only runs when its interval has elapsed
+
+		auto TimeSinceTick{ 0.0f };
+
+		{
+			auto& Bucket{ TickBuckets[BucketIdx] };
+
+			Bucket.AccumulatedTime += DeltaTime;
+
+			if (Bucket.AccumulatedTime < Bucket.Interval)
+			{
+				continue;
+			}
+
+			TimeSinceTick = Bucket.AccumulatedTime;
+			Bucket.AccumulatedTime = 0.0f;
+		}
+
+		// Buckets may be added during the ticks, so access by index each time
+
+		for (auto Idx{ 0 }; Idx < TickBuckets[BucketIdx].GamePhases.Num(); ++Idx)
+		{
+			if (auto* GamePhase{ TickBuckets[BucketIdx].GamePhases[Idx].Get() })
+			{
+				GamePhase->TickGamePhase(TimeSinceTick);
+			}
+		}
 	}
 
-	return FString();
+	// Remove game phases that ended during the ticks
+
+	for (auto BucketIdx{ TickBuckets.Num() - 1 }; BucketIdx >= 0; --BucketIdx)
+	{
+		auto& Bucket{ TickBuckets[BucketIdx] };
+
+		if (Bucket.bNeedsCompaction)
+		{
+			Bucket.GamePhases.RemoveAll([](const TObjectPtr<UGamePhase>& GamePhase) { return GamePhase == nullptr; });
+			Bucket.bNeedsCompaction = false;
+		}
+
+		if (Bucket.GamePhases.IsEmpty())
+		{
+			TickBuckets.RemoveAtSwap(BucketIdx);
+		}
+	}
+
+	UpdateShouldTick();
 }
 
 
-// Utilities
+// Expiry Timer
 
-bool UGamePhaseComponent::HasAuthority() const
+void UGamePhaseComponent::ScheduleGamePhaseExpiry(UGamePhase* GamePhase)
 {
-	auto* OwnerGameState{ GetOwner<AGameStateBase>() };
+	check(GamePhase);
 
-	return OwnerGameState ? OwnerGameState->HasAuthority() : false;
+	const auto* GameState{ GetOwner<AGameStateBase>() };
+	check(GameState);
+	const auto ServerTime{ GameState->GetServerWorldTimeSeconds() };
+
+	if (TimerWheel.IsEmpty())
+	{
+		TimerWheel.SetNum(TimerWheelSize);
+	}
+
+	// Restart the wheel from the current time if nothing was scheduled, since it is not advanced while idle
+
+	if (ExpiryTimerIds.IsEmpty())
+	{
+		TimerWheelTick = FMath::FloorToInt64(ServerTime / TimerWheelResolution);
+	}
+
+	const auto ExpireTime{ ServerTime + GamePhase->GetRemainingTime() };
+	const auto ExpireTick{ FMath::Max(FMath::CeilToInt64(ExpireTime / TimerWheelResolution), TimerWheelTick + 1) };
+
+	FGamePhaseExpiryTimer NewTimer;
+	NewTimer.GamePhaseTag = GamePhase->GetGamePhaseTag();
+	NewTimer.TimerId = ++LastExpiryTimerId;
+	NewTimer.ExpireTick = ExpireTick;
+
+	ExpiryTimerIds.Add(NewTimer.GamePhaseTag, NewTimer.TimerId);
+	TimerWheel[ExpireTick & (TimerWheelSize - 1)].Add(MoveTemp(NewTimer));
+
+	UpdateShouldTick();
+}
+
+void UGamePhaseComponent::CancelGamePhaseExpiry(const FGameplayTag& InGamePhaseTag)
+{
+	if (ExpiryTimerIds.Remove(InGamePhaseTag) > 0)
+	{
+		UpdateShouldTick();
+	}
+}
+
+bool UGamePhaseComponent::PauseGamePhaseTimer(FGameplayTag InGamePhaseTag)
+{
+	if (!HasAuthority())
+	{
+		return false;
+	}
+
+	if (!ActiveGamePhases.SetGamePhaseTimerPaused(InGamePhaseTag, true))
+	{
+		return false;
+	}
+
+	CancelGamePhaseExpiry(InGamePhaseTag);
+
+	return true;
+}
+
+bool UGamePhaseComponent::ResumeGamePhaseTimer(FGameplayTag InGamePhaseTag)
+{
+	if (!HasAuthority())
+	{
+		return false;
+	}
+
+	if (!ActiveGamePhases.SetGamePhaseTimerPaused(InGamePhaseTag, false))
+	{
+		return false;
+	}
+
+	if (auto* GamePhase{ FindGamePhaseByTag(InGamePhaseTag) })
+	{
+		ScheduleGamePhaseExpiry(GamePhase);
+	}
+
+	return true;
+}
+
+void UGamePhaseComponent::AdvanceTimerWheel()
+{
+	if (ExpiryTimerIds.IsEmpty())
+	{
+		return;
+	}
+
+	const auto* GameState{ GetOwner<AGameStateBase>() };
+	check(GameState);
+	const auto TargetTick{ FMath::FloorToInt64(GameState->GetServerWorldTimeSeconds() / TimerWheelResolution) };
+
+	// Collect the expired game phases first, since expiring them schedules and cancels other timers
+
+	TArray<FGameplayTag, TInlineAllocator<4>> ExpiredPhaseTags;
+
+	while (TimerWheelTick < TargetTick)
+	{
+		++TimerWheelTick;
+
+		auto& Slot{ TimerWheel[TimerWheelTick & (TimerWheelSize - 1)] };
+
+		for (auto Idx{ Slot.Num() - 1 }; Idx >= 0; --Idx)
+		{
+			const auto& Timer{ Slot[Idx] };
+			const auto* LiveTimerId{ ExpiryTimerIds.Find(Timer.GamePhaseTag) };
+
+			if (LiveTimerId && (*LiveTimerId == Timer.TimerId))
+			{
+				// Leave timers for a later turn of the wheel
+
+				if (Timer.ExpireTick > TimerWheelTick)
+				{
+					continue;
+				}
+
+				ExpiredPhaseTags.Add(Timer.GamePhaseTag);
+				ExpiryTimerIds.Remove(Timer.GamePhaseTag);
+			}
+
+			Slot.RemoveAtSwap(Idx);
+		}
+	}
+
+	for (const auto& ExpiredPhaseTag : ExpiredPhaseTags)
+	{
+		if (auto* GamePhase{ FindGamePhaseByTag(ExpiredPhaseTag) })
+		{
+			GamePhase->HandleGamePhaseExpired();
+		}
+	}
+
+	UpdateShouldTick();
+}
+
+
+// Prefetch
+
+bool UGamePhaseComponent::PrefetchGamePhase(TSoftClassPtr<UGamePhase> GamePhaseClass)
+{
+	if (GamePhaseClass.IsNull())
+	{
+		return false;
+	}
+
+	const auto ClassPath{ GamePhaseClass.ToSoftObjectPath() };
+
+	// Already started, or retried if the class failed to load
+
+	if (auto* Existing{ Prefetches.Find(ClassPath) })
+	{
+		if (!Existing->bFailed)
+		{
+			// Requested explicitly, so it is kept until released
+
+			Existing->bSuccessor = false;
+			return true;
+		}
+
+		Prefetches.Remove(ClassPath);
+	}
+
+	Prefetches.Add(ClassPath);
+
+	// Load the class first since the preload assets are declared on it
+
+	if (GamePhaseClass.Get())
+	{
+		HandlePrefetchClassLoaded(ClassPath);
+		return true;
+	}
+
+	auto ClassHandle
+	{
+		UAssetManager::GetStreamableManager().RequestAsyncLoad(ClassPath,
+			FStreamableDelegate::CreateUObject(this, &ThisClass::HandlePrefetchClassLoaded, ClassPath))
+	};
+
+	// The delegate may have already been called or released the prefetch
+
+	if (auto* Prefetch{ Prefetches.Find(ClassPath) })
+	{
+		Prefetch->ClassHandle = MoveTemp(ClassHandle);
+	}
+
+	return true;
+}
+
+bool UGamePhaseComponent::IsGamePhasePrefetched(TSoftClassPtr<UGamePhase> GamePhaseClass) const
+{
+	const auto* Prefetch{ Prefetches.Find(GamePhaseClass.ToSoftObjectPath()) };
+
+	return Prefetch && Prefetch->bReady && !Prefetch->bFailed;
+}
+
+void UGamePhaseComponent::ReleasePrefetchedGamePhase(TSoftClassPtr<UGamePhase> GamePhaseClass)
+{
+	FGamePhasePrefetch Prefetch;
+
+	if (!Prefetches.RemoveAndCopyValue(GamePhaseClass.ToSoftObjectPath(), Prefetch))
+	{
+		return;
+	}
+
+	// Report the release as a failure to those still waiting, after the removal since the callbacks may prefetch again
+
+	for (const auto& Callback : Prefetch.ReadyCallbacks)
+	{
+		Callback(false);
+	}
+}
+
+bool UGamePhaseComponent::SetGamePhaseWhenReady(TSoftClassPtr<UGamePhase> GamePhaseClass, float Duration)
+{
+	if (!HasAuthority())
+	{
+		return false;
+	}
+
+	return WhenGamePhasePrefetched(GamePhaseClass,
+		[WeakThis = TWeakObjectPtr<ThisClass>(this), GamePhaseClass, Duration](bool bSucceeded)
+		{
+			auto* StrongThis{ WeakThis.Get() };
+
+			if (StrongThis && bSucceeded)
+			{
+				StrongThis->SetGamePhase(GamePhaseClass.Get(), Duration);
+			}
+		}
+	);
+}
+
+bool UGamePhaseComponent::AddSubPhaseWhenReady(TSoftClassPtr<UGamePhase> GamePhaseClass, FGameplayTag InParentPhaseTag, float Duration)
+{
+	if (!HasAuthority())
+	{
+		return false;
+	}
+
+	return WhenGamePhasePrefetched(GamePhaseClass,
+		[WeakThis = TWeakObjectPtr<ThisClass>(this), GamePhaseClass, InParentPhaseTag, Duration](bool bSucceeded)
+		{
+			auto* StrongThis{ WeakThis.Get() };
+
+			if (StrongThis && bSucceeded)
+			{
+				StrongThis->AddSubPhase(GamePhaseClass.Get(), InParentPhaseTag, Duration);
+			}
+		}
+	);
+}
+
+bool UGamePhaseComponent::WhenGamePhasePrefetched(const TSoftClassPtr<UGamePhase>& GamePhaseClass, TFunction<void(bool bSucceeded)>&& Callback)
+{
+	if (!PrefetchGamePhase(GamePhaseClass))
+	{
+		return false;
+	}
+
+	auto& Prefetch{ Prefetches.FindChecked(GamePhaseClass.ToSoftObjectPath()) };
+
+	if (Prefetch.bReady)
+	{
+		Callback(!Prefetch.bFailed);
+	}
+	else
+	{
+		Prefetch.ReadyCallbacks.Add(MoveTemp(Callback));
+	}
+
+	return true;
+}
+
+void UGamePhaseComponent::HandlePrefetchClassLoaded(FSoftObjectPath ClassPath)
+{
+	if (!Prefetches.Contains(ClassPath))
+	{
+		return;
+	}
+
+	// Collect the assets declared by the class
+
+	TArray<FSoftObjectPath> AssetPaths;
+
+	if (const auto* GamePhaseClass{ Cast<UClass>(ClassPath.ResolveObject()) }; GamePhaseClass && GamePhaseClass->IsChildOf<UGamePhase>())
+	{
+		for (const auto& Asset : GamePhaseClass->GetDefaultObject<UGamePhase>()->GetPreloadAssets())
+		{
+			if (!Asset.IsNull())
+			{
+				AssetPaths.Add(Asset.ToSoftObjectPath());
+			}
+		}
+	}
+	else
+	{
+		UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Failed to prefetch game phase class: %s"), *ClassPath.ToString());
+
+		FinishPrefetch(ClassPath, false);
+		return;
+	}
+
+	if (AssetPaths.IsEmpty())
+	{
+		HandlePrefetchCompleted(ClassPath);
+		return;
+	}
+
+	auto AssetsHandle
+	{
+		UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths,
+			FStreamableDelegate::CreateUObject(this, &ThisClass::HandlePrefetchCompleted, ClassPath))
+	};
+
+	// The delegate may have already been called or released the prefetch
+
+	if (auto* Prefetch{ Prefetches.Find(ClassPath) })
+	{
+		Prefetch->AssetsHandle = MoveTemp(AssetsHandle);
+	}
+}
+
+void UGamePhaseComponent::HandlePrefetchCompleted(FSoftObjectPath ClassPath)
+{
+	FinishPrefetch(ClassPath, true);
+}
+
+void UGamePhaseComponent::FinishPrefetch(const FSoftObjectPath& ClassPath, bool bSucceeded)
+{
+	auto* Prefetch{ Prefetches.Find(ClassPath) };
+
+	if (!Prefetch || Prefetch->bReady)
+	{
+		return;
+	}
+
+	Prefetch->bReady = true;
+	Prefetch->bFailed = !bSucceeded;
+
+	// Take out since the callbacks may prefetch or release game phases
+
+	auto Callbacks{ MoveTemp(Prefetch->ReadyCallbacks) };
+
+	for (const auto& Callback : Callbacks)
+	{
+		Callback(bSucceeded);
+	}
+}
+
+
+// Class Net IDs
+
+void UGamePhaseComponent::LoadReplicatedGamePhaseClasses(TArray<FSoftObjectPath>&& ClassPaths)
+{
+	auto Handle
+	{
+		UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(ClassPaths),
+			FStreamableDelegate::CreateUObject(this, &ThisClass::HandleReplicatedGamePhaseClassesLoaded))
+	};
+
+	if (Handle.IsValid())
+	{
+		ReplicatedClassHandles.Add(MoveTemp(Handle));
+	}
+}
+
+bool UGamePhaseComponent::IsLoadingReplicatedGamePhaseClasses() const
+{
+	return ReplicatedClassHandles.ContainsByPredicate(
+		[](const TSharedPtr<FStreamableHandle>& Handle)
+		{
+			return Handle->IsLoadingInProgress();
+		}
+	);
+}
+
+void UGamePhaseComponent::HandleReplicatedGamePhaseClassesLoaded()
+{
+	ActiveGamePhases.HandleReplicatedClassesLoaded();
+
+	// Keep the loaded classes until every load has finished, since an entry may wait for classes from several loads
+
+	if (!IsLoadingReplicatedGamePhaseClasses())
+	{
+		ReplicatedClassHandles.Empty();
+	}
+}
+
+void UGamePhaseComponent::HandlePlayerPostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer)
+{
+	if (!GameMode || !NewPlayer || (GameMode->GetWorld() != GetWorld()))
+	{
+		return;
+	}
+
+	// Local players share the registry of the server
+
+	auto* Connection{ NewPlayer->GetNetConnection() };
+
+	if (!Connection || NewPlayer->IsLocalController())
+	{
+		return;
+	}
+
+	const auto* Registry{ UGamePhaseClassRegistry::Get() };
+
+	if (Registry && !Registry->DoesConnectionMatch(Connection))
+	{
+		UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Game phase class registry of [%s] does not match the server. The player is kicked."), *GetNameSafe(NewPlayer));
+
+		if (GameMode->GameSession)
+		{
+			GameMode->GameSession->KickPlayer(NewPlayer, NSLOCTEXT("GEPhase", "ClassRegistryMismatch", "Game phase classes do not match the server. Make sure the client runs the same build."));
+		}
+	}
+}
+
+
+// Transition Graph
+
+void UGamePhaseComponent::SetGamePhaseGraph(UGamePhaseGraph* NewGamePhaseGraph)
+{
+	if (!HasAuthority() || (GamePhaseGraph == NewGamePhaseGraph))
+	{
+		return;
+	}
+
+	if (NewGamePhaseGraph && !NewGamePhaseGraph->IsCompiled())
+	{
+		NewGamePhaseGraph->CompileGraph();
+	}
+
+	GamePhaseGraph = NewGamePhaseGraph;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, GamePhaseGraph, this);
+
+	// Prefetch for the game phase that is already active
+
+	PrefetchSuccessorGamePhases(ActiveGamePhases.GetCurrentGamePhaseTag());
+}
+
+void UGamePhaseComponent::PrefetchSuccessorGamePhases(const FGameplayTag& InGamePhaseTag)
+{
+	if (!GamePhaseGraph)
+	{
+		return;
+	}
+
+	TArray<TSoftClassPtr<UGamePhase>> SuccessorClasses;
+	GamePhaseGraph->GetSuccessorClasses(InGamePhaseTag, SuccessorClasses);
+
+	for (const auto& SuccessorClass : SuccessorClasses)
+	{
+		// Keep prefetches requested explicitly from being released with the successors
+
+		const auto ClassPath{ SuccessorClass.ToSoftObjectPath() };
+		const auto* Existing{ Prefetches.Find(ClassPath) };
+		const auto bSuccessor{ !Existing || Existing->bSuccessor };
+
+		if (PrefetchGamePhase(SuccessorClass))
+		{
+			if (auto* Prefetch{ Prefetches.Find(ClassPath) })
+			{
+				Prefetch->bSuccessor = bSuccessor;
+			}
+		}
+	}
+}
+
+void UGamePhaseComponent::ScheduleReleaseUnreachablePrefetches()
+{
+	// Skip the timer when there is nothing to release, since it is scheduled every time a game phase ends
+
+	if (Prefetches.IsEmpty())
+	{
+		return;
+	}
+
+	auto* World{ GetWorld() };
+
+	if (!World || World->bIsTearingDown || World->GetTimerManager().TimerExists(PrefetchReleaseTimerHandle))
+	{
+		return;
+	}
+
+	PrefetchReleaseTimerHandle = World->GetTimerManager().SetTimerForNextTick(this, &ThisClass::ReleaseUnreachablePrefetches);
+}
+
+void UGamePhaseComponent::ReleaseUnreachablePrefetches()
+{
+	PrefetchReleaseTimerHandle.Invalidate();
+
+	// Collect the classes of the active game phases and of the game phases that can follow them
+
+	TArray<FGameplayTag> ActivePhaseTags;
+	ActiveGamePhases.GetActiveGamePhaseTags(ActivePhaseTags);
+
+	TSet<FSoftObjectPath> ReachableClassPaths;
+	TArray<TSoftClassPtr<UGamePhase>> SuccessorClasses;
+
+	for (const auto& ActivePhaseTag : ActivePhaseTags)
+	{
+		if (const auto* GamePhase{ FindGamePhaseByTag(ActivePhaseTag) })
+		{
+			ReachableClassPaths.Add(FSoftObjectPath(GamePhase->GetClass()));
+		}
+
+		if (GamePhaseGraph)
+		{
+			SuccessorClasses.Reset();
+			GamePhaseGraph->GetSuccessorClasses(ActivePhaseTag, SuccessorClasses);
+
+			for (const auto& SuccessorClass : SuccessorClasses)
+			{
+				ReachableClassPaths.Add(SuccessorClass.ToSoftObjectPath());
+			}
+		}
+	}
+
+	// Release the successor prefetches that are not reachable
+
+	for (auto It{ Prefetches.CreateIterator() }; It; ++It)
+	{
+		if (It.Value().bSuccessor && !ReachableClassPaths.Contains(It.Key()))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+
+// Game Mode Option
+
+bool UGamePhaseComponent::InitializeFromGameModeOption()
+{
+	if (!HasAuthority())
+	{
+		return false;
+	}
+
+	auto* GameMode{ GetWorld()->GetAuthGameMode() };
+	if (ensure(GameMode))
+	{
+		auto OptionString{ GameMode->OptionsString };
+
+		UE_LOG(LogGameExt_GamePhase, Log, TEXT("Initialize Game Phase From Game Mode Option"));
+
+		if (UGameplayStatics::HasOption(OptionString, UGamePhaseComponent::NAME_GamePhaseOptionKey))
+		{
+			const auto PhaseClassPathFromOptions{ UGameplayStatics::ParseOption(OptionString, UGamePhaseComponent::NAME_GamePhaseOptionKey) };
+			const auto PhaseClassPath{ FSoftClassPath(PhaseClassPathFromOptions) };
+
+			UE_LOG(LogGameExt_GamePhase, Log, TEXT("| OptionValue: %s"), *PhaseClassPathFromOptions);
+			UE_LOG(LogGameExt_GamePhase, Log, TEXT("| PhaseClass: %s"), *PhaseClassPath.ToString());
+
+			const TSoftClassPtr<UGamePhase> PhaseClass{ PhaseClassPath };
+
+			if (PhaseClass.IsNull())
+			{
+				return false;
+			}
+
+			// Set right away if the class is already loaded
+
+			if (const auto LoadedClass{ PhaseClass.Get() })
+			{
+				return SetGamePhase(LoadedClass);
+			}
+
+			// Otherwise load in the background and set once ready
+			// 
+			// Tips:
+			//	Those waiting for the initial game phase are notified again if it could not be set
+
+			bGameModeOptionPending = true;
+
+			WhenGamePhasePrefetched(PhaseClass,
+				[WeakThis = TWeakObjectPtr<ThisClass>(this), PhaseClass](bool bSucceeded)
+				{
+					auto* StrongThis{ WeakThis.Get() };
+
+					if (!StrongThis)
+					{
+						return;
+					}
+
+					StrongThis->bGameModeOptionPending = false;
+
+					if (!bSucceeded || !StrongThis->SetGamePhase(PhaseClass.Get()))
+					{
+						UE_LOG(LogGameExt_GamePhase, Error, TEXT("Failed to set game phase from game mode option: %s"), *PhaseClass.ToString());
+
+						UGameFrameworkComponentManager::SendGameFrameworkComponentExtensionEvent(StrongThis->GetOwner<AGameStateBase>(), UGamePhaseComponent::NAME_GamePhaseReady);
+					}
+				}
+			);
+
+			return false;
+		}
+		else
+		{
+			UE_LOG(LogGameExt_GamePhase, Log, TEXT("| No Game Mode Option"));
+		}
+	}
+
+	return false;
+}
+
+FString UGamePhaseComponent::ConstructGameModeOption() const
+{
+	auto PhaseClass{ GetCurrentGamePhaseClass() };
+
+	if (PhaseClass)
+	{
+		FSoftClassPath Path{ PhaseClass };
+		return FString::Printf(TEXT("?%s=%s"), *UGamePhaseComponent::NAME_GamePhaseOptionKey, *Path.GetAssetPathString());
+	}
+
+	return FString();
+}
+
+
+// Utilities
+
+bool UGamePhaseComponent::HasAuthority() const
+{
+	auto* OwnerGameState{ GetOwner<AGameStateBase>() };
+
+	return OwnerGameState ? OwnerGameState->HasAuthority() : false;
+}
+
+
+//////////////////////////////////////////////////////
+// FGamePhaseTransaction
+
+FGamePhaseTransaction::FGamePhaseTransaction(UGamePhaseComponent* InComponent)
+	: Component(InComponent)
+{
+	if (InComponent && InComponent->HasAuthority())
+	{
+		InComponent->BeginGamePhaseTransaction();
+	}
+	else
+	{
+		bFinished = true;
+	}
+}
+
+FGamePhaseTransaction::~FGamePhaseTransaction()
+{
+	Commit();
+}
+
+bool FGamePhaseTransaction::Commit()
+{
+	if (bFinished)
+	{
+		return false;
+	}
+
+	bFinished = true;
+
+	auto* StrongComponent{ Component.Get() };
+	return StrongComponent ? StrongComponent->CommitGamePhaseTransaction() : false;
+}
+
+void FGamePhaseTransaction::Cancel()
+{
+	if (bFinished)
+	{
+		return;
+	}
+
+	bFinished = true;
+
+	if (auto* StrongComponent{ Component.Get() })
+	{
+		StrongComponent->CancelGamePhaseTransaction();
+	}
 }
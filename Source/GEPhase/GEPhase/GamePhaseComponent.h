@@ -9,6 +9,61 @@
 
 #include "GamePhaseComponent.generated.h"
 
+class UGamePhaseGraph;
+class AGameModeBase;
+class APlayerController;
+struct FStreamableHandle;
+
+
+/**
+ * Instances of a game phase class waiting to be reused
+ */
+USTRUCT()
+struct FGamePhaseInstancePool
+{
+	GENERATED_BODY()
+public:
+	FGamePhaseInstancePool() {}
+
+public:
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UGamePhase>> Instances;
+
+};
+
+
+/**
+ * Game phases ticked together at the same interval
+ */
+USTRUCT()
+struct FGamePhaseTickBucket
+{
+	GENERATED_BODY()
+public:
+	FGamePhaseTickBucket() {}
+
+public:
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UGamePhase>> GamePhases;
+
+	//
+	// Seconds between ticks
+	//
+	float Interval{ 0.0f };
+
+	//
+	// Seconds accumulated since the last tick
+	//
+	float AccumulatedTime{ 0.0f };
+
+	//
+	// Whether game phases were removed while ticking and left as null
+	//
+	bool bNeedsCompaction{ false };
+
+};
+
+
 /**
  * Components to manage game phases
  */
@@ -16,6 +71,9 @@ UCLASS(meta = (BlueprintSpawnableComponent))
 class GEPHASE_API UGamePhaseComponent : public UGameplayTasksComponent, public IGameFrameworkInitStateInterface
 {
 	GENERATED_BODY()
+
+	friend struct FGamePhaseTestAccess;
+
 public:
 	UGamePhaseComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
@@ -41,6 +99,10 @@ protected:
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+public:
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual bool GetShouldTick() const override;
+
 public:
 	virtual FName GetFeatureName() const override { return NAME_ActorFeatureName; }
 	virtual bool CanChangeInitState(UGameFrameworkComponentManager* Manager, FGameplayTag CurrentState, FGameplayTag DesiredState) const override;
@@ -70,25 +132,475 @@ protected:
 	FActiveGamePhaseContainer ActiveGamePhases;
 
 public:
+	/**
+	 * Notify the push model replication that the active game phases have changed
+	 */
+	void MarkActiveGamePhasesDirty();
+
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
-	bool SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass);
+	bool SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass, float Duration = 0.0f);
 
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
-	bool AddSubPhase(TSubclassOf<UGamePhase> GamePhaseClass, FGameplayTag InParentPhaseTag);
+	bool AddSubPhase(TSubclassOf<UGamePhase> GamePhaseClass, FGameplayTag InParentPhaseTag, float Duration = 0.0f);
 
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
 	bool EndPhaseByTag(FGameplayTag InGamePhaseTag);
 
+	/**
+	 * End the current game phase together with all its sub-phases, leaving no game phase active
+	 * 
+	 * Tips:
+	 *	EndPhaseByTag only ends sub-phases
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
+	bool EndAllGamePhases();
+
+	/**
+	 * Check again which players the RelevantPlayersOnly game phases are sent to
+	 * 
+	 * Tips:
+	 *	Call when the result of UGamePhase::IsRelevantToPlayer changes, such as when a player joins another team
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
+	void RefreshGamePhaseRelevancy();
+
 	UFUNCTION(BlueprintCallable, Category = "GamePhase")
 	TSubclassOf<UGamePhase> GetCurrentGamePhaseClass() const;
 
+	UFUNCTION(BlueprintCallable, Category = "GamePhase")
+	UGamePhase* FindGamePhaseByTag(FGameplayTag InGamePhaseTag) const;
+
+	/**
+	 * Returns the tag of the parent phase of the game phase, or an empty tag if it is not a sub-phase
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	FGameplayTag GetParentPhaseTag(FGameplayTag InGamePhaseTag) const;
+
+
+	////////////////////////////////////////////////////
+	// Transaction
+protected:
+	//
+	// Depth of the transactions in progress
+	//
+	int32 TransactionDepth{ 0 };
+
+	//
+	// Whether the transaction in progress was cancelled
+	//
+	bool bTransactionCancelled{ false };
+
+	//
+	// Changes recorded in the transaction in progress
+	//
+	UPROPERTY(Transient)
+	TArray<FGamePhaseTransactionOp> TransactionOps;
+
+public:
+	/**
+	 * Start recording game phase changes
+	 * 
+	 * Note:
+	 *	Authority is required
+	 * 
+	 * Tips:
+	 *	Until the transaction is committed, SetGamePhase, AddSubPhase and EndPhaseByTag only record the change 
+	 *	and return whether it is valid against the game phases as they will be at that point.
+	 *	Transactions can be nested, and the changes are applied when the outermost one is committed.
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Transaction")
+	void BeginGamePhaseTransaction();
+
+	/**
+	 * Apply the recorded changes together
+	 * 
+	 * Tips:
+	 *	All changes are validated, applied and notified as a single transition and sent to clients in a single update.
+	 *	Returns false and applies nothing if any of the changes is no longer valid or the transaction was cancelled.
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Transaction")
+	bool CommitGamePhaseTransaction();
+
+	/**
+	 * Discard the recorded changes
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Transaction")
+	void CancelGamePhaseTransaction();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Transaction")
+	bool IsInGamePhaseTransaction() const { return TransactionDepth > 0; }
+
+protected:
+	bool RecordTransactionOp(FGamePhaseTransactionOp&& Op);
+
+
+	////////////////////////////////////////////////////
+	// Prediction
+protected:
+	FTimerHandle PredictionTimeoutTimerHandle;
+
+public:
+	/**
+	 * Start a sub-phase locally ahead of the server
+	 * 
+	 * Tips:
+	 *	The server must be asked to start the same sub-phase through the game's own replicated actor, such as a player controller.
+	 *	When the server's sub-phase replicates, the predicted instance is taken over without starting it again.
+	 *	If it does not replicate within the prediction timeout, the predicted sub-phase is ended.
+	 *	On the server this is the same as AddSubPhase.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GamePhase")
+	bool PredictSubPhase(TSubclassOf<UGamePhase> GamePhaseClass, FGameplayTag InParentPhaseTag, float Duration = 0.0f);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	bool IsGamePhasePredicted(FGameplayTag InGamePhaseTag) const;
+
+protected:
+	void SchedulePredictionTimeout(double OldestPredictionTime);
+	void HandlePredictionTimeout();
+
+
+	////////////////////////////////////////////////////
+	// Instance Pool
+protected:
+	//
+	// Released instances for each game phase class that opted in to pooling
+	//
+	UPROPERTY(Transient)
+	TMap<TSubclassOf<UGamePhase>, FGamePhaseInstancePool> InstancePools;
+
+	//
+	// Number of instances reused from the pool
+	//
+	int32 NumPoolHits{ 0 };
+
+	//
+	// Number of instances newly created for classes that opted in to pooling
+	//
+	int32 NumPoolMisses{ 0 };
+
+public:
+	/**
+	 * Returns an instance of the game phase class, reusing a pooled one if possible
+	 */
+	UGamePhase* AcquireGamePhaseInstance(const TSubclassOf<UGamePhase>& GamePhaseClass);
+
+	/**
+	 * Returns an ended instance to the pool if its class opted in to pooling
+	 */
+	void ReleaseGamePhaseInstance(UGamePhase* Instance);
+
+	/**
+	 * Release all pooled instances
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GamePhase|Pool")
+	void EmptyInstancePools();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Pool")
+	int32 GetNumPoolHits() const { return NumPoolHits; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Pool")
+	int32 GetNumPoolMisses() const { return NumPoolMisses; }
+
+
+	////////////////////////////////////////////////////
+	// Game Phase Tick
+protected:
+	//
+	// Active game phases that enabled tick, grouped by interval
+	//
+	UPROPERTY(Transient)
+	TArray<FGamePhaseTickBucket> TickBuckets;
+
+	//
+	// Whether the game phases are being ticked
+	//
+	bool bTickingGamePhases{ false };
+
+public:
+	void AddTickingGamePhase(UGamePhase* GamePhase);
+	void RemoveTickingGamePhase(UGamePhase* GamePhase);
+
+protected:
+	void TickGamePhases(float DeltaTime);
+
+
+	////////////////////////////////////////////////////
+	// Expiry Timer
+protected:
+	/**
+	 * Scheduled expiry of a game phase in the timer wheel
+	 */
+	struct FGamePhaseExpiryTimer
+	{
+		FGameplayTag GamePhaseTag;
+
+		uint32 TimerId{ 0 };
+
+		int64 ExpireTick{ 0 };
+	};
+
+	//
+	// Number of slots in the timer wheel and seconds covered by each slot
+	// 
+	// Tips:
+	//	Timers further away than one turn of the wheel stay in their slot until the turn in which they expire
+	//
+	static constexpr int32 TimerWheelSize{ 256 };
+	static constexpr double TimerWheelResolution{ 0.1 };
+
+	//
+	// Slots of the hashed timer wheel, indexed by the tick in which the timers expire
+	//
+	TArray<TArray<FGamePhaseExpiryTimer>> TimerWheel;
+
+	//
+	// ID of the live timer for each scheduled game phase
+	// 
+	// Tips:
+	//	Timers in the wheel whose ID no longer matches were cancelled and are dropped when their slot is reached
+	//
+	TMap<FGameplayTag, uint32> ExpiryTimerIds;
+
+	//
+	// Last tick processed by the timer wheel
+	//
+	int64 TimerWheelTick{ 0 };
+
+	//
+	// Last ID given to a timer
+	//
+	uint32 LastExpiryTimerId{ 0 };
+
+public:
+	/**
+	 * Schedule the game phase to expire when its remaining time runs out
+	 */
+	void ScheduleGamePhaseExpiry(UGamePhase* GamePhase);
+
+	/**
+	 * Cancel the scheduled expiry of the game phase
+	 */
+	void CancelGamePhaseExpiry(const FGameplayTag& InGamePhaseTag);
+
+	/**
+	 * Pause the timer of the game phase
+	 * 
+	 * Note:
+	 *	Authority is required
+	 * 
+	 * Tips:
+	 *	Returns false if the game phase has no duration or is already paused
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Timing")
+	bool PauseGamePhaseTimer(FGameplayTag InGamePhaseTag);
+
+	/**
+	 * Resume the paused timer of the game phase
+	 * 
+	 * Note:
+	 *	Authority is required
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Timing")
+	bool ResumeGamePhaseTimer(FGameplayTag InGamePhaseTag);
+
+protected:
+	void AdvanceTimerWheel();
+
+
+	////////////////////////////////////////////////////
+	// Prefetch
+protected:
+	/**
+	 * Loading state of a game phase class and its preload assets
+	 */
+	struct FGamePhasePrefetch
+	{
+		TSharedPtr<FStreamableHandle> ClassHandle;
+		TSharedPtr<FStreamableHandle> AssetsHandle;
+
+		bool bReady{ false };
+
+		// Set together with bReady when the class could not be loaded
+		bool bFailed{ false };
+
+		// Set if only started by PrefetchSuccessorGamePhases, so that it is released once no active game phase can reach it
+		bool bSuccessor{ false };
+
+		TArray<TFunction<void(bool)>> ReadyCallbacks;
+	};
+
+	TMap<FSoftObjectPath, FGamePhasePrefetch> Prefetches;
+
+public:
+	/**
+	 * Start loading the game phase class and its preload assets in the background
+	 * 
+	 * Tips:
+	 *	The loaded class and assets are kept in memory until released or this component ends play.
+	 *	A prefetch whose class failed to load is started again.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GamePhase|Prefetch")
+	bool PrefetchGamePhase(TSoftClassPtr<UGamePhase> GamePhaseClass);
+
+	/**
+	 * Returns whether the game phase class and its preload assets have finished loading
+	 * 
+	 * Tips:
+	 *	Returns false if the class failed to load
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Prefetch")
+	bool IsGamePhasePrefetched(TSoftClassPtr<UGamePhase> GamePhaseClass) const;
+
+	/**
+	 * Stop keeping the prefetched game phase class and its preload assets in memory
+	 * 
+	 * Tips:
+	 *	Callbacks still waiting for the prefetch are called as failed
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GamePhase|Prefetch")
+	void ReleasePrefetchedGamePhase(TSoftClassPtr<UGamePhase> GamePhaseClass);
+
+	/**
+	 * Prefetch the game phase and set it once loading has finished
+	 * 
+	 * Tips:
+	 *	Returns false if the class is not valid. The result of setting the game phase is not returned.
+	 *	Nothing is set if the class fails to load.
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Prefetch")
+	bool SetGamePhaseWhenReady(TSoftClassPtr<UGamePhase> GamePhaseClass, float Duration = 0.0f);
+
+	/**
+	 * Prefetch the game phase and add it as a sub-phase once loading has finished
+	 * 
+	 * Tips:
+	 *	Returns false if the class is not valid. The result of adding the sub-phase is not returned.
+	 *	Nothing is added if the class fails to load.
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Prefetch")
+	bool AddSubPhaseWhenReady(TSoftClassPtr<UGamePhase> GamePhaseClass, FGameplayTag InParentPhaseTag, float Duration = 0.0f);
+
+	/**
+	 * Prefetch the game phase and call the callback once loading has finished
+	 * 
+	 * Tips:
+	 *	Called right away if the game phase has already been prefetched.
+	 *	bSucceeded is false if the class failed to load.
+	 */
+	bool WhenGamePhasePrefetched(const TSoftClassPtr<UGamePhase>& GamePhaseClass, TFunction<void(bool bSucceeded)>&& Callback);
+
+protected:
+	void HandlePrefetchClassLoaded(FSoftObjectPath ClassPath);
+	void HandlePrefetchCompleted(FSoftObjectPath ClassPath);
+
+	void FinishPrefetch(const FSoftObjectPath& ClassPath, bool bSucceeded);
+
+
+	////////////////////////////////////////////////////
+	// Class Net IDs
+protected:
+	//
+	// Loads of the replicated game phase classes that were not loaded when received on clients
+	//
+	TArray<TSharedPtr<FStreamableHandle>> ReplicatedClassHandles;
+
+	FDelegateHandle PostLoginHandle;
+
+public:
+	/**
+	 * Load the replicated game phase classes in the background and start their game phases once loaded
+	 */
+	void LoadReplicatedGamePhaseClasses(TArray<FSoftObjectPath>&& ClassPaths);
+
+	/**
+	 * Returns whether any replicated game phase class is still loading
+	 */
+	bool IsLoadingReplicatedGamePhaseClasses() const;
+
+protected:
+	void HandleReplicatedGamePhaseClassesLoaded();
+
+	/**
+	 * Kick the new player if its class registry does not match
+	 * 
+	 * Tips:
+	 *	The class net IDs are shared by all connections, so a client that does not agree on them cannot be served
+	 */
+	void HandlePlayerPostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer);
+
+
+	////////////////////////////////////////////////////
+	// Transition Graph
+protected:
+	//
+	// Graph that declares the transitions allowed between game phases
+	// 
+	// Tips:
+	//	If not set, any transition is allowed.
+	//	The game phases that can follow each game phase are prefetched when it starts.
+	//
+	UPROPERTY(EditAnywhere, Replicated, Category = "GamePhase")
+	TObjectPtr<UGamePhaseGraph> GamePhaseGraph{ nullptr };
+
+public:
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	UGamePhaseGraph* GetGamePhaseGraph() const { return GamePhaseGraph; }
+
+	/**
+	 * Change the graph that declares the transitions allowed between game phases
+	 * 
+	 * Note:
+	 *	Authority is required
+	 * 
+	 * Tips:
+	 *	The game phases that are already active are kept even if the new graph does not allow them
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
+	void SetGamePhaseGraph(UGamePhaseGraph* NewGamePhaseGraph);
+
+	/**
+	 * Prefetch the game phases that the graph allows to follow the game phase
+	 */
+	void PrefetchSuccessorGamePhases(const FGameplayTag& InGamePhaseTag);
+
+	/**
+	 * Release the successor prefetches that are no longer reachable from the active game phases on the next tick
+	 * 
+	 * Tips:
+	 *	Deferred so that a game phase started right after the previous one ended keeps its prefetch
+	 */
+	void ScheduleReleaseUnreachablePrefetches();
+
+protected:
+	FTimerHandle PrefetchReleaseTimerHandle;
+
+	void ReleaseUnreachablePrefetches();
+
 
 	////////////////////////////////////////////////////
 	// Game Mode Option
+protected:
+	//
+	// Whether the game phase specified by the game mode option is being loaded
+	//
+	bool bGameModeOptionPending{ false };
+
 public:
+	/**
+	 * Set the game phase specified by the game mode option
+	 * 
+	 * Tips:
+	 *	Returns true only if the game phase has been set.
+	 *	If the class has to be loaded first, returns false and sets the game phase once loaded.
+	 *	IsGameModeOptionPending returns true until then, and NAME_GamePhaseReady is sent again if it could not be set.
+	 */
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
 	virtual bool InitializeFromGameModeOption();
 
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	bool IsGameModeOptionPending() const { return bGameModeOptionPending; }
+
 	UFUNCTION(BlueprintCallable, Category = "GamePhase")
 	virtual FString ConstructGameModeOption() const;
 
@@ -99,3 +611,28 @@ public:
 	bool HasAuthority() const;
 
 };
+
+
+/**
+ * Scope to apply all game phase changes made within it together
+ * 
+ * Tips:
+ *	Committed when the scope ends unless committed or cancelled earlier
+ */
+struct GEPHASE_API FGamePhaseTransaction
+{
+public:
+	explicit FGamePhaseTransaction(UGamePhaseComponent* InComponent);
+	~FGamePhaseTransaction();
+
+private:
+	TWeakObjectPtr<UGamePhaseComponent> Component;
+
+	bool bFinished{ false };
+
+public:
+	bool Commit();
+
+	void Cancel();
+
+};
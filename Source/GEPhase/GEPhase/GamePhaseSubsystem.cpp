@@ -3,134 +3,1136 @@
 #include "GamePhaseSubsystem.h"
 
 #include "GamePhaseComponent.h"
+#include "Phase/GamePhase.h"
 #include "GEPhaseLogs.h"
+#include "GEPhaseStats.h"
+#include "Setting/GEPhaseDeveloperSettings.h"
 
 #include "GameFramework/GameStateBase.h"
+#include "GameplayTagsManager.h"
+#include "Algo/BinarySearch.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GamePhaseSubsystem)
 
 
+DECLARE_CYCLE_STAT(TEXT("Broadcast Event"), STAT_GamePhase_BroadcastEvent, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("Broadcast Transition"), STAT_GamePhase_BroadcastTransition, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("Build Dispatch List"), STAT_GamePhase_BuildDispatchList, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("Flush Queued Events"), STAT_GamePhase_FlushQueuedEvents, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("Compact Listeners"), STAT_GamePhase_CompactListeners, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("Update Query Listeners"), STAT_GamePhase_UpdateQueryListeners, STATGROUP_GamePhase);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Notified Listeners"), STAT_GamePhase_NumNotifiedListeners, STATGROUP_GamePhase);
+
+
+/**
+ * Set the bit of the net index of the tag
+ */
+static void SetTagNetIndexBit(TBitArray<>& Bits, const FGameplayTag& Tag)
+{
+	const auto NetIndex{ static_cast<int32>(UGameplayTagsManager::Get().GetNetIndexFromTag(Tag)) };
+
+	if (NetIndex != INVALID_TAGNETINDEX)
+	{
+		if (NetIndex >= Bits.Num())
+		{
+			Bits.Add(false, NetIndex + 1 - Bits.Num());
+		}
+
+		Bits[NetIndex] = true;
+	}
+}
+
+/**
+ * Set the bits of the net indices of the tags, and of the tags and their parents
+ */
+static void BuildTagBits(const TArray<FGameplayTag>& Tags, TBitArray<>& OutExplicitBits, TBitArray<>& OutImplicitBits)
+{
+	if (OutExplicitBits.Num() > 0)
+	{
+		OutExplicitBits.SetRange(0, OutExplicitBits.Num(), false);
+	}
+
+	if (OutImplicitBits.Num() > 0)
+	{
+		OutImplicitBits.SetRange(0, OutImplicitBits.Num(), false);
+	}
+
+	for (const auto& GamePhaseTag : Tags)
+	{
+		SetTagNetIndexBit(OutExplicitBits, GamePhaseTag);
+
+		for (auto Tag{ GamePhaseTag }; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+		{
+			SetTagNetIndexBit(OutImplicitBits, Tag);
+		}
+	}
+}
+
+/**
+ * Returns the last of the tags that is referenced by the bits, either itself or through one of its parents
+ */
+static FGameplayTag FindLastTagInBits(const TBitArray<>& Bits, const TArray<FGameplayTag>& Tags)
+{
+	const auto& TagsManager{ UGameplayTagsManager::Get() };
+
+	for (auto Idx{ Tags.Num() - 1 }; Idx >= 0; --Idx)
+	{
+		for (auto Tag{ Tags[Idx] }; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+		{
+			const auto NetIndex{ static_cast<int32>(TagsManager.GetNetIndexFromTag(Tag)) };
+
+			if ((NetIndex != INVALID_TAGNETINDEX) && (NetIndex < Bits.Num()) && Bits[NetIndex])
+			{
+				return Tags[Idx];
+			}
+		}
+	}
+
+	return FGameplayTag::EmptyTag;
+}
+
+
+//////////////////////////////////////////////////////
+// FGamePhaseEventFlushTickFunction
+
+void FGamePhaseEventFlushTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->FlushQueuedGamePhaseEvents(Target->EventFlushBudgetSeconds);
+	}
+}
+
+FString FGamePhaseEventFlushTickFunction::DiagnosticMessage()
+{
+	return FString::Printf(TEXT("FGamePhaseEventFlushTickFunction[%s]"), *GetNameSafe(Target));
+}
+
+
+//////////////////////////////////////////////////////
+// UGamePhaseSubsystem
+
+void UGamePhaseSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const auto* DevSettings{ GetDefault<UGEPhaseDeveloperSettings>() };
+
+	EventDeliveryMode = DevSettings->EventDeliveryMode;
+	EventFlushBudgetSeconds = DevSettings->EventFlushBudgetMs / 1000.0;
+
+	EventFlushTickFunction.Target = this;
+	EventFlushTickFunction.TickGroup = DevSettings->EventFlushTickGroup;
+	EventFlushTickFunction.bCanEverTick = true;
+	EventFlushTickFunction.bStartWithTickEnabled = false;
+	EventFlushTickFunction.bTickEvenWhenPaused = true;
+}
+
+void UGamePhaseSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	EventFlushTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+	EventFlushTickFunction.SetTickFunctionEnable(HasQueuedGamePhaseEvents());
+}
+
 void UGamePhaseSubsystem::Deinitialize()
 {
+	if (EventFlushTickFunction.IsTickFunctionRegistered())
+	{
+		EventFlushTickFunction.UnRegisterTickFunction();
+	}
+
+	EventQueue.Reset();
+	EventQueueHead = 0;
+
+	DispatchMap.Reset();
+	DispatchLists.Empty();
+	TransitionDispatchList.ListenerIndices.Reset();
+	QueryListeners.Reset();
+	ExplicitTagBits.Reset();
+	ImplicitTagBits.Reset();
+	ScratchExplicitTagBits.Reset();
+	ScratchImplicitTagBits.Reset();
 	ListenerMap.Reset();
+	Listeners.Empty();
+	FreeListenerIndices.Reset();
+	PendingRemovalIndices.Reset();
+	PendingInsertionIndices.Reset();
 	GamePhaseTagCache.Reset();
+	GamePhaseTagContainer.Reset();
+	ParentTagCounts.Reset();
+	PendingTransition.Reset();
+	HeldEvents.Reset();
+	bHoldingEvents = false;
 
 	Super::Deinitialize();
 }
 
 
-// Game Phase Cache
+// Game Phase Cache
+
+void UGamePhaseSubsystem::AddGamePhaseTag(const FGameplayTag& GamePhaseTag)
+{
+	GamePhaseTagCache.Emplace(GamePhaseTag);
+	GamePhaseTagContainer.AddTag(GamePhaseTag);
+	++GamePhaseTagVersion;
+
+	for (auto ParentTag{ GamePhaseTag.RequestDirectParent() }; ParentTag.IsValid(); ParentTag = ParentTag.RequestDirectParent())
+	{
+		++ParentTagCounts.FindOrAdd(ParentTag);
+	}
+
+	BeginGamePhaseTransition();
+
+	PendingTransition.StartedPhaseTags.Add(GamePhaseTag);
+	DispatchGamePhaseEvent(GamePhaseTag, EGamePhaseEventType::Start);
+
+	EndGamePhaseTransition();
+}
+
+void UGamePhaseSubsystem::RemoveGamePhaseTag(const FGameplayTag& GamePhaseTag)
+{
+	// The game phase that ends is usually one of the last to start, so search from the back
+
+	auto bParentTagsChanged{ false };
+
+	const auto CacheIndex{ GamePhaseTagCache.FindLast(GamePhaseTag) };
+	if (CacheIndex != INDEX_NONE)
+	{
+		GamePhaseTagCache.RemoveAt(CacheIndex);
+
+		// Rebuild the parent tags only if one of them is no longer under any active game phase tag
+
+		for (auto ParentTag{ GamePhaseTag.RequestDirectParent() }; ParentTag.IsValid(); ParentTag = ParentTag.RequestDirectParent())
+		{
+			if (auto* Count{ ParentTagCounts.Find(ParentTag) }; Count && (--(*Count) <= 0))
+			{
+				ParentTagCounts.Remove(ParentTag);
+				bParentTagsChanged = true;
+			}
+		}
+	}
+
+	GamePhaseTagContainer.RemoveTag(GamePhaseTag, true);
+
+	if (bParentTagsChanged)
+	{
+		GamePhaseTagContainer.FillParentTags();
+	}
+
+	++GamePhaseTagVersion;
+
+	BeginGamePhaseTransition();
+
+	PendingTransition.EndedPhaseTags.Add(GamePhaseTag);
+	DispatchGamePhaseEvent(GamePhaseTag, EGamePhaseEventType::End);
+
+	EndGamePhaseTransition();
+}
+
+const FGameplayTag& UGamePhaseSubsystem::GetLastTransitionGamePhaseTag() const
+{
+	return GamePhaseTagCache.IsEmpty() ? FGameplayTag::EmptyTag : GamePhaseTagCache.Top();
+}
+
+bool UGamePhaseSubsystem::IsGamePhaseActive(FGameplayTag GamePhaseTag, EGamePhaseTagMatchType MatchType) const
+{
+	return (MatchType == EGamePhaseTagMatchType::PartialMatch) ? GamePhaseTagContainer.HasTag(GamePhaseTag) : GamePhaseTagContainer.HasTagExact(GamePhaseTag);
+}
+
+bool UGamePhaseSubsystem::HasAnyGamePhases(const FGameplayTagContainer& GamePhaseTags, EGamePhaseTagMatchType MatchType) const
+{
+	return (MatchType == EGamePhaseTagMatchType::PartialMatch) ? GamePhaseTagContainer.HasAny(GamePhaseTags) : GamePhaseTagContainer.HasAnyExact(GamePhaseTags);
+}
+
+bool UGamePhaseSubsystem::HasAllGamePhases(const FGameplayTagContainer& GamePhaseTags, EGamePhaseTagMatchType MatchType) const
+{
+	return (MatchType == EGamePhaseTagMatchType::PartialMatch) ? GamePhaseTagContainer.HasAll(GamePhaseTags) : GamePhaseTagContainer.HasAllExact(GamePhaseTags);
+}
+
+
+// Listner
+
+FGamePhaseListenerHandle UGamePhaseSubsystem::RegisterListener(FGameplayTag GamePhaseTag, TFunction<void(FGameplayTag, EGamePhaseEventType)>&& Callback, EGamePhaseTagMatchType MatchType, bool bReplayActivePhases, EGamePhaseListenerPriority Priority)
+{
+	const auto ListenerIndex{ AllocateListener(Priority) };
+
+	Listeners[ListenerIndex].ReceivedCallback = MoveTemp(Callback);
+
+	return AddListenerToDispatch(ListenerIndex, GamePhaseTag, MatchType, bReplayActivePhases);
+}
+
+FGamePhaseListenerHandle UGamePhaseSubsystem::RegisterListener(FGameplayTag GamePhaseTag, FGamePhaseEventNativeDelegate&& Delegate, EGamePhaseTagMatchType MatchType, bool bReplayActivePhases, EGamePhaseListenerPriority Priority)
+{
+	const auto ListenerIndex{ AllocateListener(Priority) };
+
+	Listeners[ListenerIndex].ReceivedDelegate = MoveTemp(Delegate);
+
+	return AddListenerToDispatch(ListenerIndex, GamePhaseTag, MatchType, bReplayActivePhases);
+}
+
+FGamePhaseListenerHandle UGamePhaseSubsystem::RegisterListener(const FGameplayTagQuery& Query, TFunction<void(FGameplayTag, EGamePhaseEventType)>&& Callback, bool bReplayActivePhases, EGamePhaseListenerPriority Priority)
+{
+	const auto ListenerIndex{ AllocateListener(Priority) };
+
+	Listeners[ListenerIndex].ReceivedCallback = MoveTemp(Callback);
+
+	return AddQueryListener(ListenerIndex, Query, bReplayActivePhases);
+}
+
+FGamePhaseListenerHandle UGamePhaseSubsystem::RegisterTransitionListener(TFunction<void(const FGamePhaseTransition&)>&& Callback, EGamePhaseListenerPriority Priority)
+{
+	const auto ListenerIndex{ AllocateListener(Priority) };
+
+	auto& Entry{ Listeners[ListenerIndex] };
+	Entry.TransitionCallback = MoveTemp(Callback);
+
+	InsertListener(ListenerIndex);
+
+	return FGamePhaseListenerHandle(this, ListenerIndex, Entry.Generation);
+}
+
+void UGamePhaseSubsystem::UnregisterListener(FGamePhaseListenerHandle Handle)
+{
+	if (!Handle.IsValid())
+	{
+		UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Trying to unregister an invalid Handle."));
+		return;
+	}
+
+	check(Handle.Subsystem == this);
+
+	// Stale handles refer to a slot that has been released or reused since
+
+	if ((Handle.SlotIndex < 0) || (Handle.SlotIndex >= Listeners.Num()))
+	{
+		return;
+	}
+
+	auto& Listener{ Listeners[Handle.SlotIndex] };
+
+	if (!Listener.IsAlive() || (Listener.Generation != Handle.Generation))
+	{
+		return;
+	}
+
+	MarkListenerPendingRemoval(Handle.SlotIndex);
+}
+
+void UGamePhaseSubsystem::UnregisterListener(FGameplayTag GamePhaseTag, int32 HandleID)
+{
+	const auto IsMatchingListener
+	{
+		[this, &GamePhaseTag, HandleID](int32 ListenerIndex)
+		{
+			const auto& Listener{ Listeners[ListenerIndex] };
+
+			return Listener.IsAlive() && (Listener.SerialNumber == HandleID) && (Listener.GamePhaseTag == GamePhaseTag);
+		}
+	};
+
+	// Listeners registered during a broadcast are not in the channel list yet
+
+	const int32* ListenerIndex{ nullptr };
+
+	if (const auto* List{ ListenerMap.Find(GamePhaseTag) })
+	{
+		ListenerIndex = List->ListenerIndices.FindByPredicate(IsMatchingListener);
+	}
+
+	if (!ListenerIndex)
+	{
+		ListenerIndex = PendingInsertionIndices.FindByPredicate(IsMatchingListener);
+	}
+
+	if (!ListenerIndex)
+	{
+		UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Trying to unregister a listener that is not registered: %s (%d)"), *GamePhaseTag.ToString(), HandleID);
+		return;
+	}
+
+	UnregisterListener(FGamePhaseListenerHandle(this, *ListenerIndex, Listeners[*ListenerIndex].Generation));
+}
+
+int32 UGamePhaseSubsystem::AllocateListener(EGamePhaseListenerPriority Priority)
+{
+	const auto ListenerIndex{ FreeListenerIndices.IsEmpty() ? Listeners.AddElement(FGamePhaseListenerData()) : FreeListenerIndices.Pop() };
+
+	auto& Entry{ Listeners[ListenerIndex] };
+	Entry.Priority = Priority;
+	Entry.SerialNumber = ++LastSerialNumber;
+	Entry.bPendingRemoval = false;
+
+	return ListenerIndex;
+}
+
+void UGamePhaseSubsystem::InsertListener(int32 ListenerIndex)
+{
+	if (BroadcastDepth > 0)
+	{
+		PendingInsertionIndices.Add(ListenerIndex);
+		return;
+	}
+
+	const auto& Entry{ Listeners[ListenerIndex] };
+
+	const auto InsertSorted
+	{
+		[this, ListenerIndex](TArray<int32>& ListenerIndices)
+		{
+			const auto InsertIndex
+			{
+				Algo::UpperBound(ListenerIndices, ListenerIndex,
+					[this](int32 A, int32 B)
+					{
+						return Listeners[A].Precedes(Listeners[B]);
+					}
+				)
+			};
+
+			ListenerIndices.Insert(ListenerIndex, InsertIndex);
+		}
+	};
+
+	// Transition listener
+
+	if (Entry.TransitionCallback)
+	{
+		InsertSorted(TransitionDispatchList.ListenerIndices);
+		return;
+	}
+
+	// Tag listener
+
+	ListenerMap.FindOrAdd(Entry.GamePhaseTag).ListenerIndices.Add(ListenerIndex);
+
+	for (const auto& KVP : DispatchMap)
+	{
+		if (Entry.AppliesTo(KVP.Key))
+		{
+			InsertSorted(DispatchLists[KVP.Value].ListenerIndices);
+		}
+	}
+}
+
+void UGamePhaseSubsystem::FlushPendingListenerChanges()
+{
+	if (BroadcastDepth > 0)
+	{
+		return;
+	}
+
+	if (!PendingRemovalIndices.IsEmpty())
+	{
+		CompactListeners();
+	}
+
+	if (!PendingInsertionIndices.IsEmpty())
+	{
+		// Listeners unregistered before being inserted have already been released by the compaction above
+
+		for (const auto& ListenerIndex : PendingInsertionIndices)
+		{
+			if (Listeners[ListenerIndex].IsAlive())
+			{
+				InsertListener(ListenerIndex);
+			}
+		}
+
+		PendingInsertionIndices.Reset();
+	}
+}
+
+FGamePhaseListenerHandle UGamePhaseSubsystem::AddListenerToDispatch(int32 ListenerIndex, const FGameplayTag& GamePhaseTag, EGamePhaseTagMatchType MatchType, bool bReplayActivePhases)
+{
+	auto& Entry{ Listeners[ListenerIndex] };
+	Entry.GamePhaseTag = GamePhaseTag;
+	Entry.MatchType = MatchType;
+
+	InsertListener(ListenerIndex);
+
+	const auto Handle{ FGamePhaseListenerHandle(this, ListenerIndex, Entry.Generation) };
+
+	if (bReplayActivePhases)
+	{
+		ReplayActivePhases(ListenerIndex);
+	}
+
+	return Handle;
+}
+
+FGamePhaseListenerHandle UGamePhaseSubsystem::AddQueryListener(int32 ListenerIndex, const FGameplayTagQuery& Query, bool bReplayActivePhases)
+{
+	// Active tag bits are not maintained while there are no query listeners
+
+	if (QueryListeners.IsEmpty())
+	{
+		BuildTagBits(GamePhaseTagCache, ExplicitTagBits, ImplicitTagBits);
+	}
+
+	// Query listeners are never iterated while callbacks are running, so they can be inserted right away
+
+	const auto InsertIndex
+	{
+		Algo::UpperBoundBy(QueryListeners, Listeners[ListenerIndex],
+			[this](const FGamePhaseQueryListener& Other) -> const FGamePhaseListenerData&
+			{
+				return Listeners[Other.ListenerIndex];
+			},
+			[](const FGamePhaseListenerData& A, const FGamePhaseListenerData& B)
+			{
+				return A.Precedes(B);
+			}
+		)
+	};
+
+	auto& QueryListener{ QueryListeners.InsertDefaulted_GetRef(InsertIndex) };
+	QueryListener.ListenerIndex = ListenerIndex;
+
+	// Compile the query into the bits of the tags it references
+	// 
+	// Tips:
+	//	Evaluated against the current tags, since the active tag bits are only updated at the end of a transition
+
+	QueryListener.Query.Compile(Query, QueryListener.RelevantTagBits);
+
+	BuildTagBits(GamePhaseTagCache, ScratchExplicitTagBits, ScratchImplicitTagBits);
+	QueryListener.bMatched = QueryListener.Query.Matches(ScratchExplicitTagBits, ScratchImplicitTagBits);
+
+	const auto Handle{ FGamePhaseListenerHandle(this, ListenerIndex, Listeners[ListenerIndex].Generation) };
+
+	if (!bReplayActivePhases)
+	{
+		return Handle;
+	}
+
+	// Evaluate the query against what the other listeners have been notified of, and leave the queued events to the flush tick
+
+	const auto bMatched{ QueryListener.bMatched };
+	auto bNotifiedMatched{ bMatched };
+
+	TArray<FGameplayTag> NotifiedTags;
+	GetNotifiedGamePhaseTags(NotifiedTags);
+
+	if (HasQueuedGamePhaseEvents() || !HeldEvents.IsEmpty())
+	{
+		BuildTagBits(NotifiedTags, ScratchExplicitTagBits, ScratchImplicitTagBits);
+		bNotifiedMatched = QueryListener.Query.Matches(ScratchExplicitTagBits, ScratchImplicitTagBits);
+	}
+
+	// Resolve the tags before notifying, since the callback may register other query listeners and move this one
+
+	auto NotifiedCauseTag{ FindLastTagInBits(QueryListener.RelevantTagBits, NotifiedTags) };
+	auto CurrentCauseTag{ FindLastTagInBits(QueryListener.RelevantTagBits, bMatched ? GamePhaseTagCache : NotifiedTags) };
+
+	if (!NotifiedCauseTag.IsValid() && !NotifiedTags.IsEmpty())
+	{
+		NotifiedCauseTag = NotifiedTags.Last();
+	}
+
+	if (!CurrentCauseTag.IsValid())
+	{
+		CurrentCauseTag = GetLastTransitionGamePhaseTag();
+	}
+
+	const auto SerialNumber{ Listeners[ListenerIndex].SerialNumber };
+
+	// Receives Start once if the query matches as notified so far
+
+	if (bNotifiedMatched)
+	{
+		NotifyListener(ListenerIndex, NotifiedCauseTag, EGamePhaseEventType::Start);
+	}
+
+	// Receives the change made since then after the queued events, as the other listeners do, unless unregistered by the callback
+
+	const auto& Listener{ Listeners[ListenerIndex] };
+
+	if ((bNotifiedMatched != bMatched) && Listener.IsAlive() && (Listener.SerialNumber == SerialNumber))
+	{
+		DispatchListenerEvent(ListenerIndex, CurrentCauseTag, bMatched ? EGamePhaseEventType::Start : EGamePhaseEventType::End);
+	}
+
+	return Handle;
+}
+
+void UGamePhaseSubsystem::ReplayActivePhases(int32 ListenerIndex)
+{
+	// Replay only what the other listeners have been notified of, and leave the queued events to the flush tick.
+	// The listener is already in the dispatch lists, so it receives the queued events along with the others.
+
+	TArray<FGameplayTag> NotifiedTags;
+	GetNotifiedGamePhaseTags(NotifiedTags);
+
+	const auto ReplayedTags{ NotifiedTags };
+	const auto TagVersion{ GamePhaseTagVersion };
+	const auto SerialNumber{ Listeners[ListenerIndex].SerialNumber };
+
+	// Receives Start for each matching game phase in the order they started
+	// 
+	// Tips:
+	//	Stop if the listener is unregistered, and skip the game phases ended by the callbacks in the meantime
+
+	for (const auto& GamePhaseTag : ReplayedTags)
+	{
+		const auto& Listener{ Listeners[ListenerIndex] };
+
+		if (!Listener.IsAlive() || (Listener.SerialNumber != SerialNumber))
+		{
+			break;
+		}
+
+		if (!Listener.AppliesTo(GamePhaseTag))
+		{
+			continue;
+		}
+
+		if (GamePhaseTagVersion != TagVersion)
+		{
+			NotifiedTags.Reset();
+			GetNotifiedGamePhaseTags(NotifiedTags);
+
+			if (!NotifiedTags.Contains(GamePhaseTag))
+			{
+				continue;
+			}
+		}
+
+		NotifyListener(ListenerIndex, GamePhaseTag, EGamePhaseEventType::Start);
+	}
+}
+
+void UGamePhaseSubsystem::GetNotifiedGamePhaseTags(TArray<FGameplayTag>& OutGamePhaseTags) const
+{
+	OutGamePhaseTags.Append(GamePhaseTagCache);
+
+	// Undo the changes whose events have not been delivered yet, latest first
+
+	const auto UndoEvent
+	{
+		[&OutGamePhaseTags](const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType)
+		{
+			if (EventType == EGamePhaseEventType::End)
+			{
+				OutGamePhaseTags.Add(GamePhaseTag);
+			}
+			else
+			{
+				const auto TagIndex{ OutGamePhaseTags.FindLast(GamePhaseTag) };
+
+				if (TagIndex != INDEX_NONE)
+				{
+					OutGamePhaseTags.RemoveAt(TagIndex);
+				}
+			}
+		}
+	};
+
+	for (auto Idx{ HeldEvents.Num() - 1 }; Idx >= 0; --Idx)
+	{
+		UndoEvent(HeldEvents[Idx].Key, HeldEvents[Idx].Value);
+	}
+
+	for (auto Idx{ EventQueue.Num() - 1 }; Idx >= EventQueueHead; --Idx)
+	{
+		const auto& Event{ EventQueue[Idx] };
+
+		if (!Event.bIsTransition && (Event.ListenerIndex == INDEX_NONE))
+		{
+			UndoEvent(Event.GamePhaseTag, Event.EventType);
+		}
+	}
+}
+
+void UGamePhaseSubsystem::MarkListenerPendingRemoval(int32 ListenerIndex)
+{
+	auto& Listener{ Listeners[ListenerIndex] };
+
+	// Only mark here since the listener may be referenced by a broadcast in progress.
+	// The lists are compacted all at once before the next broadcast.
+
+	Listener.bPendingRemoval = true;
+	Listener.Generation = (Listener.Generation == MAX_int32) ? 1 : (Listener.Generation + 1);
+
+	PendingRemovalIndices.Add(ListenerIndex);
+
+	// Release the captures right away unless the callback may be running
+
+	if (BroadcastDepth == 0)
+	{
+		Listener.ReceivedCallback.Reset();
+		Listener.TransitionCallback.Reset();
+		Listener.ReceivedDelegate.Unbind();
+	}
+}
+
+const UGamePhaseSubsystem::FGamePhaseDispatchList& UGamePhaseSubsystem::FindOrBuildDispatchList(const FGameplayTag& BroadcastTag)
+{
+	if (const auto* ExistingListIndex{ DispatchMap.Find(BroadcastTag) })
+	{
+		return DispatchLists[*ExistingListIndex];
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_BuildDispatchList);
+
+	const auto NewListIndex{ DispatchLists.AddElement(FGamePhaseDispatchList()) };
+	auto& NewList{ DispatchLists[NewListIndex] };
+
+	for (auto Tag{ BroadcastTag }; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+	{
+		if (const auto* List{ ListenerMap.Find(Tag) })
+		{
+			for (const auto& ListenerIndex : List->ListenerIndices)
+			{
+				const auto& Listener{ Listeners[ListenerIndex] };
+
+				// The receiving type must be either a parent of the sending type or completely ambiguous (for internal use)
+
+				if (Listener.IsAlive() && Listener.AppliesTo(BroadcastTag))
+				{
+					NewList.ListenerIndices.Add(ListenerIndex);
+				}
+			}
+		}
+	}
+
+	NewList.ListenerIndices.Sort(
+		[this](int32 A, int32 B)
+		{
+			return Listeners[A].Precedes(Listeners[B]);
+		}
+	);
+
+	DispatchMap.Add(BroadcastTag, NewListIndex);
+
+	return NewList;
+}
+
+void UGamePhaseSubsystem::CompactListeners()
+{
+	check(BroadcastDepth == 0);
+
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_CompactListeners);
 
-void UGamePhaseSubsystem::AddGamePhaseTag(const FGameplayTag& GamePhaseTag)
+	const auto IsPendingRemoval
+	{
+		[this](int32 ListenerIndex)
+		{
+			return Listeners[ListenerIndex].bPendingRemoval;
+		}
+	};
+
+	// Remove from lists in a single pass while keeping the order of the remaining listeners
+
+	for (const auto& KVP : DispatchMap)
+	{
+		DispatchLists[KVP.Value].ListenerIndices.RemoveAll(IsPendingRemoval);
+	}
+
+	TransitionDispatchList.ListenerIndices.RemoveAll(IsPendingRemoval);
+
+	QueryListeners.RemoveAll(
+		[&IsPendingRemoval](const FGamePhaseQueryListener& QueryListener)
+		{
+			return IsPendingRemoval(QueryListener.ListenerIndex);
+		}
+	);
+
+	for (auto It{ ListenerMap.CreateIterator() }; It; ++It)
+	{
+		It->Value.ListenerIndices.RemoveAll(IsPendingRemoval);
+
+		if (It->Value.ListenerIndices.IsEmpty())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// Release slots
+
+	for (const auto& ListenerIndex : PendingRemovalIndices)
+	{
+		auto& Listener{ Listeners[ListenerIndex] };
+
+		const auto Generation{ Listener.Generation };
+		Listener = FGamePhaseListenerData();
+		Listener.Generation = Generation;
+
+		FreeListenerIndices.Add(ListenerIndex);
+	}
+
+	PendingRemovalIndices.Reset();
+}
+
+void UGamePhaseSubsystem::BroadcastGamePhaseEvent(FGameplayTag GamePhaseTag, EGamePhaseEventType EventType)
 {
-	GamePhaseTagCache.Emplace(GamePhaseTag);
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_BroadcastEvent);
+
+	// Iterate the live list without copying it
+	// 
+	// Tips:
+	//	Removals during callbacks are deferred until the outermost broadcast finishes, so the indices stay stable.
+	//	Listeners registered during callbacks are inserted afterwards and do not receive the event in progress.
 
-	BroadcastGamePhaseEvent(GamePhaseTag, EGamePhaseEventType::Start);
+	FlushPendingListenerChanges();
+
+	const auto& DispatchList{ FindOrBuildDispatchList(GamePhaseTag) };
+	const auto NumListeners{ DispatchList.ListenerIndices.Num() };
+
+	INC_DWORD_STAT_BY(STAT_GamePhase_NumNotifiedListeners, NumListeners);
+
+	++BroadcastDepth;
+
+	for (auto Idx{ 0 }; Idx < NumListeners; ++Idx)
+	{
+		const auto ListenerIndex{ DispatchList.ListenerIndices[Idx] };
+		const auto& Listener{ Listeners[ListenerIndex] };
+
+		// Skip listeners removed by the previous callbacks
+
+		if (Listener.IsAlive())
+		{
+			// Reclaim listeners whose bound object no longer exists
+
+			if (!Listener.Invoke(GamePhaseTag, EventType))
+			{
+				MarkListenerPendingRemoval(ListenerIndex);
+			}
+		}
+	}
+
+	--BroadcastDepth;
+
+	FlushPendingListenerChanges();
 }
 
-void UGamePhaseSubsystem::RemoveGamePhaseTag(const FGameplayTag& GamePhaseTag)
+void UGamePhaseSubsystem::BroadcastGamePhaseTransition(const FGamePhaseTransition& Transition)
 {
-	GamePhaseTagCache.Remove(GamePhaseTag);
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_BroadcastTransition);
 
-	BroadcastGamePhaseEvent(GamePhaseTag, EGamePhaseEventType::End);
+	FlushPendingListenerChanges();
+
+	const auto NumListeners{ TransitionDispatchList.ListenerIndices.Num() };
+
+	INC_DWORD_STAT_BY(STAT_GamePhase_NumNotifiedListeners, NumListeners);
+
+	++BroadcastDepth;
+
+	for (auto Idx{ 0 }; Idx < NumListeners; ++Idx)
+	{
+		const auto& Listener{ Listeners[TransitionDispatchList.ListenerIndices[Idx]] };
+
+		if (Listener.IsAlive())
+		{
+			Listener.TransitionCallback(Transition);
+		}
+	}
+
+	--BroadcastDepth;
+
+	FlushPendingListenerChanges();
 }
 
-const FGameplayTag& UGamePhaseSubsystem::GetLastTransitionGamePhaseTag() const
+void UGamePhaseSubsystem::NotifyListener(int32 ListenerIndex, const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType)
 {
-	return GamePhaseTagCache.IsEmpty() ? FGameplayTag::EmptyTag : GamePhaseTagCache.Top();
+	FlushPendingListenerChanges();
+
+	const auto& Listener{ Listeners[ListenerIndex] };
+
+	if (!Listener.IsAlive())
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_GamePhase_NumNotifiedListeners);
+
+	++BroadcastDepth;
+
+	if (!Listener.Invoke(GamePhaseTag, EventType))
+	{
+		MarkListenerPendingRemoval(ListenerIndex);
+	}
+
+	--BroadcastDepth;
+
+	FlushPendingListenerChanges();
 }
 
-FGameplayTagContainer UGamePhaseSubsystem::GetGamePhaseTags() const
+void UGamePhaseSubsystem::UpdateQueryListeners()
 {
-	return FGameplayTagContainer::CreateFromArray(GamePhaseTagCache);
+	if (QueryListeners.IsEmpty() || PendingTransition.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_UpdateQueryListeners);
+
+	// Find the bits changed by the transition
+
+	BuildTagBits(GamePhaseTagCache, ScratchExplicitTagBits, ScratchImplicitTagBits);
+	Swap(ExplicitTagBits, ScratchExplicitTagBits);
+	Swap(ImplicitTagBits, ScratchImplicitTagBits);
+
+	ScratchExplicitTagBits.CombineWithBitwiseXOR(ExplicitTagBits, EBitwiseOperatorFlags::MaxSize);
+	ScratchImplicitTagBits.CombineWithBitwiseXOR(ImplicitTagBits, EBitwiseOperatorFlags::MaxSize);
+
+	auto& ChangedTagBits{ ScratchExplicitTagBits };
+	ChangedTagBits.CombineWithBitwiseOR(ScratchImplicitTagBits, EBitwiseOperatorFlags::MaxSize);
+
+	const auto& StartedTags{ PendingTransition.StartedPhaseTags };
+	const auto& EndedTags{ PendingTransition.EndedPhaseTags };
+
+	// Evaluate all queries first so that transitions made by the listeners see the updated results
+
+	struct FChangedQueryListener
+	{
+		int32 ListenerIndex{ INDEX_NONE };
+		FGameplayTag CauseTag;
+		EGamePhaseEventType EventType{ EGamePhaseEventType::Start };
+	};
+
+	TArray<FChangedQueryListener, TInlineAllocator<8>> ChangedListeners;
+
+	for (auto& QueryListener : QueryListeners)
+	{
+		if (!Listeners[QueryListener.ListenerIndex].IsAlive())
+		{
+			continue;
+		}
+
+		auto bRelevant{ false };
+
+		for (TConstSetBitIterator<> It(QueryListener.RelevantTagBits); It; ++It)
+		{
+			const auto BitIndex{ It.GetIndex() };
+
+			if ((BitIndex < ChangedTagBits.Num()) && ChangedTagBits[BitIndex])
+			{
+				bRelevant = true;
+				break;
+			}
+		}
+
+		if (bRelevant)
+		{
+			const auto bMatched{ QueryListener.Query.Matches(ExplicitTagBits, ImplicitTagBits) };
+
+			if (bMatched != QueryListener.bMatched)
+			{
+				QueryListener.bMatched = bMatched;
+
+				// The cause is the last tag referenced by the query among the tags started, for Start, or ended, for End.
+				// Falls back to the other list, since a query may also start matching when a tag ends and vice versa.
+
+				const auto& PrimaryTags{ bMatched ? StartedTags : EndedTags };
+				const auto& SecondaryTags{ bMatched ? EndedTags : StartedTags };
+
+				auto CauseTag{ FindLastTagInBits(QueryListener.RelevantTagBits, PrimaryTags) };
+
+				if (!CauseTag.IsValid())
+				{
+					CauseTag = FindLastTagInBits(QueryListener.RelevantTagBits, SecondaryTags);
+				}
+
+				ChangedListeners.Add({ QueryListener.ListenerIndex, CauseTag, bMatched ? EGamePhaseEventType::Start : EGamePhaseEventType::End });
+			}
+		}
+	}
+
+	for (const auto& Changed : ChangedListeners)
+	{
+		DispatchListenerEvent(Changed.ListenerIndex, Changed.CauseTag, Changed.EventType);
+	}
 }
 
 
-// Listner
+// Transition
 
-FGamePhaseListenerHandle UGamePhaseSubsystem::RegisterListener(FGameplayTag GamePhaseTag, TFunction<void(FGameplayTag, EGamePhaseEventType)>&& Callback, EGamePhaseTagMatchType MatchType)
+void UGamePhaseSubsystem::BeginGamePhaseTransition(bool bHoldEvents)
 {
-	auto& List{ ListenerMap.FindOrAdd(GamePhaseTag) };
-
-	auto& Entry{ List.Listeners.AddDefaulted_GetRef() };
-	Entry.ReceivedCallback = MoveTemp(Callback);
-	Entry.HandleID = ++List.HandleID;
-	Entry.MatchType = MatchType;
+	++TransitionDepth;
 
-	return FGamePhaseListenerHandle(this, GamePhaseTag, Entry.HandleID);
+	bHoldingEvents |= bHoldEvents;
 }
 
-void UGamePhaseSubsystem::UnregisterListener(FGamePhaseListenerHandle Handle)
+void UGamePhaseSubsystem::EndGamePhaseTransition()
 {
-	if (Handle.IsValid())
+	check(TransitionDepth > 0);
+
+	// Deliver the held events while the transition is still in progress, so that changes made by the listeners join it
+
+	while ((TransitionDepth == 1) && bHoldingEvents)
 	{
-		check(Handle.Subsystem == this);
+		bHoldingEvents = false;
 
-		UnregisterListener(Handle.GamePhaseTag, Handle.ID);
+		const auto Events{ MoveTemp(HeldEvents) };
+		HeldEvents.Reset();
+
+		for (const auto& Event : Events)
+		{
+			DispatchGamePhaseEvent(Event.Key, Event.Value);
+		}
 	}
-	else
+
+	if ((--TransitionDepth > 0) || PendingTransition.IsEmpty())
 	{
-		UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Trying to unregister an invalid Handle."));
+		return;
 	}
+
+	UpdateQueryListeners();
+
+	DispatchPendingTransition();
 }
 
-void UGamePhaseSubsystem::UnregisterListener(FGameplayTag GamePhaseTag, int32 HandleID)
+
+// Event Delivery
+
+void UGamePhaseSubsystem::SetEventDeliveryMode(EGamePhaseEventDeliveryMode NewMode)
 {
-	if (auto* List{ ListenerMap.Find(GamePhaseTag) })
+	if (EventDeliveryMode != NewMode)
 	{
-		auto MatchIndex
+		EventDeliveryMode = NewMode;
+
+		if (NewMode == EGamePhaseEventDeliveryMode::Immediate)
 		{
-			List->Listeners.IndexOfByPredicate(
-				[ID = HandleID](const FGamePhaseListenerData& Other)
-				{
-					return Other.HandleID == ID;
-				}
-			)
-		};
+			FlushQueuedGamePhaseEvents();
+		}
+	}
+}
+
+void UGamePhaseSubsystem::FlushQueuedGamePhaseEvents(double BudgetSeconds)
+{
+	// Events queued by the listeners are appended and delivered by the flush in progress
+
+	if (bFlushingEvents)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_FlushQueuedEvents);
+
+	TGuardValue<bool> FlushGuard{ bFlushingEvents, true };
+
+	const auto StartTime{ FPlatformTime::Seconds() };
+
+	while (EventQueueHead < EventQueue.Num())
+	{
+		// Move out since the queue may grow while delivering
+
+		auto Event{ MoveTemp(EventQueue[EventQueueHead++]) };
+
+		if (Event.bIsTransition)
+		{
+			BroadcastGamePhaseTransition(Event.Transition);
+		}
+		else if (Event.ListenerIndex != INDEX_NONE)
+		{
+			// Skip if the listener slot has been released since
 
-		if (MatchIndex != INDEX_NONE)
+			if (Listeners[Event.ListenerIndex].SerialNumber == Event.ListenerSerialNumber)
+			{
+				NotifyListener(Event.ListenerIndex, Event.GamePhaseTag, Event.EventType);
+			}
+		}
+		else
 		{
-			List->Listeners.RemoveAtSwap(MatchIndex);
+			BroadcastGamePhaseEvent(Event.GamePhaseTag, Event.EventType);
 		}
 
-		if (List->Listeners.Num() == 0)
+		if ((BudgetSeconds > 0.0) && ((FPlatformTime::Seconds() - StartTime) >= BudgetSeconds))
 		{
-			ListenerMap.Remove(GamePhaseTag);
+			break;
 		}
 	}
+
+	// Release delivered events
+
+	if (EventQueueHead >= EventQueue.Num())
+	{
+		EventQueue.Reset();
+		EventQueueHead = 0;
+	}
+	else if ((EventQueueHead * 2) > EventQueue.Num())
+	{
+		EventQueue.RemoveAt(0, EventQueueHead);
+		EventQueueHead = 0;
+	}
+
+	EventFlushTickFunction.SetTickFunctionEnable(HasQueuedGamePhaseEvents());
+}
+
+void UGamePhaseSubsystem::DispatchGamePhaseEvent(const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType)
+{
+	if (bHoldingEvents)
+	{
+		HeldEvents.Emplace(GamePhaseTag, EventType);
+	}
+	else if (EventDeliveryMode == EGamePhaseEventDeliveryMode::Queued)
+	{
+		auto& Event{ EventQueue.AddDefaulted_GetRef() };
+		Event.GamePhaseTag = GamePhaseTag;
+		Event.EventType = EventType;
+
+		EventFlushTickFunction.SetTickFunctionEnable(true);
+	}
+	else
+	{
+		BroadcastGamePhaseEvent(GamePhaseTag, EventType);
+	}
 }
 
-void UGamePhaseSubsystem::BroadcastGamePhaseEvent(FGameplayTag GamePhaseTag, EGamePhaseEventType EventType)
+void UGamePhaseSubsystem::DispatchListenerEvent(int32 ListenerIndex, const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType)
 {
-	auto bOnInitialTag{ true };
+	if (EventDeliveryMode == EGamePhaseEventDeliveryMode::Queued)
+	{
+		auto& Event{ EventQueue.AddDefaulted_GetRef() };
+		Event.GamePhaseTag = GamePhaseTag;
+		Event.EventType = EventType;
+		Event.ListenerIndex = ListenerIndex;
+		Event.ListenerSerialNumber = Listeners[ListenerIndex].SerialNumber;
 
-	for (auto Tag{ GamePhaseTag }; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+		EventFlushTickFunction.SetTickFunctionEnable(true);
+	}
+	else
 	{
-		if (const auto* List{ ListenerMap.Find(Tag) })
-		{
-			// Copy in case there are removals while handling callbacks
+		NotifyListener(ListenerIndex, GamePhaseTag, EventType);
+	}
+}
 
-			auto ListenerArray{ TArray<FGamePhaseListenerData>(List->Listeners) };
+void UGamePhaseSubsystem::DispatchPendingTransition()
+{
+	if (EventDeliveryMode == EGamePhaseEventDeliveryMode::Queued)
+	{
+		auto& Event{ EventQueue.AddDefaulted_GetRef() };
+		Event.bIsTransition = true;
+		Swap(Event.Transition, PendingTransition);
 
-			for (const auto& Listener : ListenerArray)
-			{
-				if (bOnInitialTag || (Listener.MatchType == EGamePhaseTagMatchType::PartialMatch))
-				{
-					// The receiving type must be either a parent of the sending type or completely ambiguous (for internal use)
+		EventFlushTickFunction.SetTickFunctionEnable(true);
+	}
+	else
+	{
+		// Take the pending transition out so that transitions made by the listeners are collected separately
 
-					Listener.ReceivedCallback(GamePhaseTag, EventType);
-				}
-			}
-		}
+		FGamePhaseTransition Transition;
+		Swap(Transition, PendingTransition);
+
+		BroadcastGamePhaseTransition(Transition);
 
-		bOnInitialTag = false;
+		// Give the buffers back for reuse
+
+		if (PendingTransition.IsEmpty())
+		{
+			Transition.Reset();
+			Swap(Transition, PendingTransition);
+		}
 	}
 }
 
 
 // Utilities
 
-bool UGamePhaseSubsystem::SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass)
+bool UGamePhaseSubsystem::SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass, float Duration)
 {
 	if (!GamePhaseClass)
 	{
@@ -141,7 +1143,7 @@ bool UGamePhaseSubsystem::SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass)
 	{
 		if (auto* Component{ GameState->FindComponentByClass<UGamePhaseComponent>() })
 		{
-			return Component->SetGamePhase(GamePhaseClass);
+			return Component->SetGamePhase(GamePhaseClass, Duration);
 		}
 	}
 
@@ -166,6 +1168,72 @@ bool UGamePhaseSubsystem::EndGamePhase(FGameplayTag GamePhaseTag)
 	return false;
 }
 
+UGamePhase* UGamePhaseSubsystem::FindGamePhase(FGameplayTag GamePhaseTag) const
+{
+	if (auto* GameState{ GetWorld()->GetGameState() })
+	{
+		if (auto* Component{ GameState->FindComponentByClass<UGamePhaseComponent>() })
+		{
+			return Component->FindGamePhaseByTag(GamePhaseTag);
+		}
+	}
+
+	return nullptr;
+}
+
+bool UGamePhaseSubsystem::PrefetchGamePhase(TSoftClassPtr<UGamePhase> GamePhaseClass)
+{
+	if (auto* GameState{ GetWorld()->GetGameState() })
+	{
+		if (auto* Component{ GameState->FindComponentByClass<UGamePhaseComponent>() })
+		{
+			return Component->PrefetchGamePhase(GamePhaseClass);
+		}
+	}
+
+	return false;
+}
+
+bool UGamePhaseSubsystem::IsGamePhasePrefetched(TSoftClassPtr<UGamePhase> GamePhaseClass) const
+{
+	if (auto* GameState{ GetWorld()->GetGameState() })
+	{
+		if (auto* Component{ GameState->FindComponentByClass<UGamePhaseComponent>() })
+		{
+			return Component->IsGamePhasePrefetched(GamePhaseClass);
+		}
+	}
+
+	return false;
+}
+
+bool UGamePhaseSubsystem::IsGamePhasePredicted(FGameplayTag GamePhaseTag) const
+{
+	if (auto* GameState{ GetWorld()->GetGameState() })
+	{
+		if (auto* Component{ GameState->FindComponentByClass<UGamePhaseComponent>() })
+		{
+			return Component->IsGamePhasePredicted(GamePhaseTag);
+		}
+	}
+
+	return false;
+}
+
+float UGamePhaseSubsystem::GetGamePhaseElapsedTime(FGameplayTag GamePhaseTag) const
+{
+	const auto* GamePhase{ FindGamePhase(GamePhaseTag) };
+
+	return GamePhase ? GamePhase->GetElapsedTime() : -1.0f;
+}
+
+float UGamePhaseSubsystem::GetGamePhaseRemainingTime(FGameplayTag GamePhaseTag) const
+{
+	const auto* GamePhase{ FindGamePhase(GamePhaseTag) };
+
+	return GamePhase ? GamePhase->GetRemainingTime() : -1.0f;
+}
+
 
 // Game Mode Option
 
@@ -194,3 +1262,24 @@ FString UGamePhaseSubsystem::ConstructGameModeOption() const
 
 	return FString();
 }
+
+
+//////////////////////////////////////////////////////
+// FGamePhaseTransitionScope
+
+FGamePhaseTransitionScope::FGamePhaseTransitionScope(UGamePhaseSubsystem* InSubsystem, bool bHoldEvents)
+	: Subsystem(InSubsystem)
+{
+	if (InSubsystem)
+	{
+		InSubsystem->BeginGamePhaseTransition(bHoldEvents);
+	}
+}
+
+FGamePhaseTransitionScope::~FGamePhaseTransitionScope()
+{
+	if (auto* StrongSubsystem{ Subsystem.Get() })
+	{
+		StrongSubsystem->EndGamePhaseTransition();
+	}
+}
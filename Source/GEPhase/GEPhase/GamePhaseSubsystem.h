@@ -3,16 +3,37 @@
 #pragma once
 
 #include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Containers/ChunkedArray.h"
 
 #include "Type/GamePhaseListenerTypes.h"
 
 #include "GamePhaseSubsystem.generated.h"
 
 class UGamePhase;
+class UGamePhaseSubsystem;
 class UAsyncAction_ListenForGamePhase;
 struct FActiveGamePhaseContainer;
 
 
+/**
+ * Tick function to deliver the queued game phase events
+ */
+struct FGamePhaseEventFlushTickFunction : public FTickFunction
+{
+public:
+	FGamePhaseEventFlushTickFunction() {}
+
+public:
+	UGamePhaseSubsystem* Target{ nullptr };
+
+public:
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+
+};
+
+
 /** 
  * Subsystem to track current game phase
  */
@@ -23,11 +44,15 @@ class GEPHASE_API UGamePhaseSubsystem : public UWorldSubsystem
 
 	friend class UAsyncAction_ListenForGamePhase;
 	friend struct FActiveGamePhaseContainer;
+	friend struct FGamePhaseEventFlushTickFunction;
+	friend struct FGamePhaseTestAccess;
 
 public:
 	UGamePhaseSubsystem() {}
 
 public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
 	virtual void Deinitialize() override;
 
 	////////////////////////////////////////////////////
@@ -42,6 +67,28 @@ protected:
 	UPROPERTY(Transient)
 	TArray<FGameplayTag> GamePhaseTagCache;
 
+	//
+	// Container of the tags for the currently active game phase
+	// 
+	// Tips:
+	//	Kept in sync with GamePhaseTagCache and also holds the parent tags, so that it can be queried without rebuilding
+	//
+	UPROPERTY(Transient)
+	FGameplayTagContainer GamePhaseTagContainer;
+
+	//
+	// Number of active game phase tags under each parent tag
+	// 
+	// Tips:
+	//	The parent tags of GamePhaseTagContainer are only rebuilt when one of the counts drops to zero
+	//
+	TMap<FGameplayTag, int32> ParentTagCounts;
+
+	//
+	// Incremented each time the active game phase tags change
+	//
+	int32 GamePhaseTagVersion{ 0 };
+
 protected:
 	void AddGamePhaseTag(const FGameplayTag& GamePhaseTag);
 	void RemoveGamePhaseTag(const FGameplayTag& GamePhaseTag);
@@ -51,57 +98,542 @@ public:
 	const FGameplayTag& GetLastTransitionGamePhaseTag() const;
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
-	FGameplayTagContainer GetGamePhaseTags() const;
+	const FGameplayTagContainer& GetGamePhaseTags() const { return GamePhaseTagContainer; }
+
+	/**
+	 * Returns version of the active game phase tags
+	 * 
+	 * Tips:
+	 *	Can be compared with the previously returned value to know if the active game phases have changed
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	int32 GetGamePhaseTagVersion() const { return GamePhaseTagVersion; }
+
+	/**
+	 * Returns whether the specified game phase is active
+	 * 
+	 * Tips:
+	 *	With PartialMatch, also returns true if a child game phase of the specified one is active
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	bool IsGamePhaseActive(UPARAM(meta = (Categories = "GamePhase")) FGameplayTag GamePhaseTag, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch) const;
+
+	/**
+	 * Returns whether any of the specified game phases is active
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	bool HasAnyGamePhases(UPARAM(meta = (Categories = "GamePhase")) const FGameplayTagContainer& GamePhaseTags, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch) const;
+
+	/**
+	 * Returns whether all of the specified game phases are active
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	bool HasAllGamePhases(UPARAM(meta = (Categories = "GamePhase")) const FGameplayTagContainer& GamePhaseTags, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch) const;
 
 
 	////////////////////////////////////////////////////
 	// Listner
 protected:
 	/**
-	 * List of all entries for a given channel
+	 * List of all listener indices registered for a given channel
 	 */
 	struct FChannelListenerList
 	{
-		TArray<FGamePhaseListenerData> Listeners;
-		int32 HandleID{ 0 };
+		TArray<int32> ListenerIndices;
+	};
+
+	/**
+	 * Flat list of all listeners to be notified when a event is broadcast on a given tag
+	 *
+	 * Tips:
+	 *	Contains the exact match listeners of the tag and the partial match listeners of the tag and its parents,
+	 *	sorted by priority and then by registration order
+	 */
+	struct FGamePhaseDispatchList
+	{
+		TArray<int32> ListenerIndices;
 	};
 
 	//
-	// Listen data map for game phase related to GameplayTag
+	// All registered listeners
+	// 
+	// Tips:
+	//	Chunked so that the listener being called is never moved by registrations made from within its callback.
+	//	Released slots are listed in FreeListenerIndices and reused by later registrations.
+	//
+	TChunkedArray<FGamePhaseListenerData> Listeners;
+	TArray<int32> FreeListenerIndices;
+
+	//
+	// Listener indices for game phase related to GameplayTag
 	//
 	TMap<FGameplayTag, FChannelListenerList> ListenerMap;
 
+	//
+	// Precompiled dispatch lists for each tag that has been broadcast
+	//
+	// Tips:
+	//	Built on the first broadcast of a tag and kept up to date incrementally on registration and unregistration.
+	//	DispatchMap holds indices into DispatchLists so that lists are not moved when a nested broadcast builds a new one.
+	//
+	TMap<FGameplayTag, int32> DispatchMap;
+	TChunkedArray<FGamePhaseDispatchList> DispatchLists;
+
+	//
+	// Dispatch list of the listeners registered by RegisterTransitionListener
+	//
+	FGamePhaseDispatchList TransitionDispatchList;
+
+	/**
+	 * Listener registered with a gameplay tag query
+	 */
+	struct FGamePhaseQueryListener
+	{
+		int32 ListenerIndex{ INDEX_NONE };
+
+		FGamePhaseCompiledTagQuery Query;
+
+		//
+		// Net indices of the tags referenced by the query
+		//
+		TBitArray<> RelevantTagBits;
+
+		//
+		// Result of the last evaluation of the query
+		//
+		bool bMatched{ false };
+	};
+
+	//
+	// Listeners registered with a gameplay tag query
+	//
+	TArray<FGamePhaseQueryListener> QueryListeners;
+
+	//
+	// Net indices of the active game phase tags themselves, and of the tags together with their parents
+	// 
+	// Tips:
+	//	Kept apart so that starting or ending a parent tag of an active tag is seen by exact queries.
+	//	Queries are only re-evaluated when a bit they reference changes in either.
+	//
+	TBitArray<> ExplicitTagBits;
+	TBitArray<> ImplicitTagBits;
+	TBitArray<> ScratchExplicitTagBits;
+	TBitArray<> ScratchImplicitTagBits;
+
+	//
+	// Listener indices unregistered since the last compaction, waiting to be removed from the lists
+	// 
+	// Tips:
+	//	Removal from the lists is batched so that unregistering many listeners at once stays linear overall
+	//
+	TArray<int32> PendingRemovalIndices;
+
+	//
+	// Listener indices registered during broadcast, waiting to be inserted into the lists
+	//
+	TArray<int32> PendingInsertionIndices;
+
+	//
+	// Number of broadcasts currently in progress
+	//
+	int32 BroadcastDepth{ 0 };
+
+	//
+	// Last issued listener serial number
+	//
+	int32 LastSerialNumber{ 0 };
+
 public:
 	/**
 	 * Register to receive messages on a specified GamePhaseTag
+	 * 
+	 * Tips:
+	 *	If bReplayActivePhases is true, Start is received synchronously for the already active game phases
+	 *	that match the listener, in the order they started.
+	 *	Game phases whose events are still queued are received when the queue is delivered instead.
+	 * 
+	 *	Listeners receive events in the order of Priority, then in the order they were registered.
 	 */
 	FGamePhaseListenerHandle RegisterListener(
 		FGameplayTag GamePhaseTag
 		, TFunction<void(FGameplayTag, EGamePhaseEventType)>&& Callback
-		, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch);
+		, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch
+		, bool bReplayActivePhases = false
+		, EGamePhaseListenerPriority Priority = EGamePhaseListenerPriority::Default);
+
+	/**
+	 * Register to receive messages on a specified GamePhaseTag with a delegate
+	 */
+	FGamePhaseListenerHandle RegisterListener(
+		FGameplayTag GamePhaseTag
+		, FGamePhaseEventNativeDelegate&& Delegate
+		, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch
+		, bool bReplayActivePhases = false
+		, EGamePhaseListenerPriority Priority = EGamePhaseListenerPriority::Default);
 
 	/**
-	 * Remove a GamePhase listener previously registered by RegisterListener
+	 * Register to receive messages on a specified GamePhaseTag with a member function of a object
+	 * 
+	 * Tips:
+	 *	Requires no heap allocation. 
+	 *	The listener is skipped and unregistered automatically once the object no longer exists.
+	 */
+	template<typename UserClass>
+	FGamePhaseListenerHandle RegisterListener(
+		FGameplayTag GamePhaseTag
+		, UserClass* Object
+		, void (UserClass::* Func)(FGameplayTag, EGamePhaseEventType)
+		, EGamePhaseTagMatchType MatchType = EGamePhaseTagMatchType::ExactMatch
+		, bool bReplayActivePhases = false
+		, EGamePhaseListenerPriority Priority = EGamePhaseListenerPriority::Default)
+	{
+		const auto ListenerIndex{ AllocateListener(Priority) };
+
+		BindNativeListener(ListenerIndex, Object, Func);
+
+		return AddListenerToDispatch(ListenerIndex, GamePhaseTag, MatchType, bReplayActivePhases);
+	}
+
+	/**
+	 * Register to be notified when the result of the query against the active game phases changes
+	 * 
+	 * Tips:
+	 *	Start is received when the query starts matching and End when it stops matching,
+	 *	along with the game phase tag whose transition changed the result.
+	 *	The tag is the last one referenced by the query that started, for Start, or that ended, for End.
+	 *	If there is none, such as when the query starts matching because a tag ended, the last one of the other kind is used.
+	 *	The query is re-evaluated only when a tag it references, or a tag under one, is started or ended.
+	 *	If bReplayActivePhases is true and the query already matches, Start is received synchronously.
+	 *	The game phases whose events are still queued are left out, and the change they make is received when the queue is delivered.
+	 */
+	FGamePhaseListenerHandle RegisterListener(
+		const FGameplayTagQuery& Query
+		, TFunction<void(FGameplayTag, EGamePhaseEventType)>&& Callback
+		, bool bReplayActivePhases = false
+		, EGamePhaseListenerPriority Priority = EGamePhaseListenerPriority::Default);
+
+	template<typename UserClass>
+	FGamePhaseListenerHandle RegisterListener(
+		const FGameplayTagQuery& Query
+		, UserClass* Object
+		, void (UserClass::* Func)(FGameplayTag, EGamePhaseEventType)
+		, bool bReplayActivePhases = false
+		, EGamePhaseListenerPriority Priority = EGamePhaseListenerPriority::Default)
+	{
+		const auto ListenerIndex{ AllocateListener(Priority) };
+
+		BindNativeListener(ListenerIndex, Object, Func);
+
+		return AddQueryListener(ListenerIndex, Query, bReplayActivePhases);
+	}
+
+	/**
+	 * Register to receive every game phase transition as a single event
+	 * 
+	 * Tips:
+	 *	Unlike RegisterListener, a transition that ends and starts several game phases is notified only once
+	 */
+	FGamePhaseListenerHandle RegisterTransitionListener(
+		TFunction<void(const FGamePhaseTransition&)>&& Callback
+		, EGamePhaseListenerPriority Priority = EGamePhaseListenerPriority::Default);
+
+	/**
+	 * Remove a GamePhase listener previously registered by RegisterListener or RegisterTransitionListener
 	 */
 	void UnregisterListener(FGamePhaseListenerHandle Handle);
+
+	/**
+	 * Remove a GamePhase listener by the tag it listens on and its ID
+	 * 
+	 * Tips:
+	 *	The ID is the registration serial number of the listener, since handles no longer carry a tag and an ID
+	 */
+	UE_DEPRECATED(5.3, "Use UnregisterListener(FGamePhaseListenerHandle) instead.")
 	void UnregisterListener(FGameplayTag GamePhaseTag, int32 HandleID);
 
 protected:
+	/**
+	 * Returns new listener slot index
+	 */
+	int32 AllocateListener(EGamePhaseListenerPriority Priority);
+
+	/**
+	 * Insert the listener into the lists it belongs to, keeping the lists sorted by priority and registration order
+	 * 
+	 * Tips:
+	 *	Deferred while a broadcast is in progress, so that the list being iterated is never reordered
+	 */
+	void InsertListener(int32 ListenerIndex);
+
+	/**
+	 * Apply the listener removals and insertions deferred during broadcast
+	 */
+	void FlushPendingListenerChanges();
+
+	/**
+	 * Set the channel of the allocated listener and add it to the dispatch lists
+	 */
+	FGamePhaseListenerHandle AddListenerToDispatch(int32 ListenerIndex, const FGameplayTag& GamePhaseTag, EGamePhaseTagMatchType MatchType, bool bReplayActivePhases);
+
+	/**
+	 * Compile the query of the allocated listener and add it to the query listeners
+	 */
+	FGamePhaseListenerHandle AddQueryListener(int32 ListenerIndex, const FGameplayTagQuery& Query, bool bReplayActivePhases);
+
+	/**
+	 * Notify the tag listener of Start for the already active game phases that match it
+	 * 
+	 * Tips:
+	 *	Only the game phases that the other listeners have been notified of are replayed.
+	 *	The changes whose events are still queued reach the new listener when the queue is delivered.
+	 */
+	void ReplayActivePhases(int32 ListenerIndex);
+
+	/**
+	 * Returns the active game phase tags as the listeners have been notified of them so far
+	 * 
+	 * Tips:
+	 *	Leaves out the changes whose events are queued or held for the transition in progress
+	 */
+	void GetNotifiedGamePhaseTags(TArray<FGameplayTag>& OutGamePhaseTags) const;
+
+	/**
+	 * Bind the member function of the object to the allocated listener
+	 */
+	template<typename UserClass>
+	void BindNativeListener(int32 ListenerIndex, UserClass* Object, void (UserClass::* Func)(FGameplayTag, EGamePhaseEventType))
+	{
+		using FFuncType = void (UserClass::*)(FGameplayTag, EGamePhaseEventType);
+
+		static_assert(TIsDerivedFrom<UserClass, UObject>::Value, "Object must be derived from UObject.");
+		static_assert(sizeof(FFuncType) <= FGamePhaseListenerData::NativeFuncStorageSize, "Member function pointer does not fit in the listener.");
+
+		check(Object);
+		check(Func);
+
+		auto& Entry{ Listeners[ListenerIndex] };
+		Entry.NativeOwner = Object;
+		FMemory::Memcpy(Entry.NativeFuncStorage, &Func, sizeof(FFuncType));
+		Entry.NativeThunk =
+			[](UObject* InObject, const void* InFuncStorage, FGameplayTag InGamePhaseTag, EGamePhaseEventType InEventType)
+			{
+				FFuncType TypedFunc;
+				FMemory::Memcpy(&TypedFunc, InFuncStorage, sizeof(FFuncType));
+
+				(static_cast<UserClass*>(InObject)->*TypedFunc)(InGamePhaseTag, InEventType);
+			};
+	}
+
+	/**
+	 * Mark the listener as unregistered
+	 */
+	void MarkListenerPendingRemoval(int32 ListenerIndex);
+
+	/**
+	 * Re-evaluate the query listeners affected by the pending transition and notify those whose result changed
+	 */
+	void UpdateQueryListeners();
+
+	/**
+	 * Returns dispatch list for the specified broadcast tag, building it if it does not exist yet
+	 */
+	const FGamePhaseDispatchList& FindOrBuildDispatchList(const FGameplayTag& BroadcastTag);
+
+	/**
+	 * Remove unregistered listeners from the lists and release their slots
+	 */
+	void CompactListeners();
+
 	/**
 	 * Broadcast a event on the specified game phase
 	 */
 	void BroadcastGamePhaseEvent(FGameplayTag GamePhaseTag, EGamePhaseEventType EventType);
 
+	/**
+	 * Broadcast a transition to the transition listeners
+	 */
+	void BroadcastGamePhaseTransition(const FGamePhaseTransition& Transition);
+
+
+	////////////////////////////////////////////////////
+	// Transition
+protected:
+	//
+	// Game phases ended and started since the outermost BeginGamePhaseTransition
+	//
+	FGamePhaseTransition PendingTransition;
+
+	//
+	// Number of transitions currently in progress
+	//
+	int32 TransitionDepth{ 0 };
+
+	//
+	// Whether per-tag events are held until the outermost transition ends
+	//
+	bool bHoldingEvents{ false };
+
+	//
+	// Per-tag events held for the transition in progress, in the order they occurred
+	//
+	TArray<TPair<FGameplayTag, EGamePhaseEventType>> HeldEvents;
+
+public:
+	/**
+	 * Start collecting game phase changes into a single transition
+	 * 
+	 * Tips:
+	 *	Per-tag events are broadcast immediately unless bHoldEvents is true, 
+	 *	in which case they are broadcast in order when the outermost EndGamePhaseTransition is called.
+	 *	The transition is broadcast when the outermost EndGamePhaseTransition is called.
+	 */
+	void BeginGamePhaseTransition(bool bHoldEvents = false);
+
+	/**
+	 * Finish collecting game phase changes and broadcast the transition
+	 */
+	void EndGamePhaseTransition();
+
+
+	////////////////////////////////////////////////////
+	// Event Delivery
+protected:
+	/**
+	 * Game phase event waiting to be delivered
+	 */
+	struct FQueuedGamePhaseEvent
+	{
+		FGameplayTag GamePhaseTag;
+		EGamePhaseEventType EventType{ EGamePhaseEventType::Start };
+
+		bool bIsTransition{ false };
+		FGamePhaseTransition Transition;
+
+		//
+		// Set if the event is only for the specified listener
+		//
+		int32 ListenerIndex{ INDEX_NONE };
+		int32 ListenerSerialNumber{ 0 };
+	};
+
+	//
+	// How game phase events are currently delivered
+	//
+	EGamePhaseEventDeliveryMode EventDeliveryMode{ EGamePhaseEventDeliveryMode::Immediate };
+
+	//
+	// Events waiting to be delivered in Queued mode, in the order they occurred
+	// 
+	// Tips:
+	//	Events before EventQueueHead have already been delivered
+	//
+	TArray<FQueuedGamePhaseEvent> EventQueue;
+	int32 EventQueueHead{ 0 };
+
+	//
+	// Time budget per frame for delivering queued events (in seconds, 0 means no limit)
+	//
+	double EventFlushBudgetSeconds{ 0.0 };
+
+	//
+	// Tick function that delivers the queued events
+	// 
+	// Tips:
+	//	Only enabled while there are queued events
+	//
+	FGamePhaseEventFlushTickFunction EventFlushTickFunction;
+
+	bool bFlushingEvents{ false };
+
+public:
+	/**
+	 * Change how game phase events are delivered
+	 * 
+	 * Tips:
+	 *	Switching to Immediate delivers all queued events first
+	 */
+	void SetEventDeliveryMode(EGamePhaseEventDeliveryMode NewMode);
+
+	EGamePhaseEventDeliveryMode GetEventDeliveryMode() const { return EventDeliveryMode; }
+
+	bool HasQueuedGamePhaseEvents() const { return EventQueueHead < EventQueue.Num(); }
+
+	/**
+	 * Deliver queued events in order until the time budget is exceeded
+	 * 
+	 * Tips:
+	 *	At least one event is delivered per call. 0 means no limit.
+	 */
+	void FlushQueuedGamePhaseEvents(double BudgetSeconds = 0.0);
+
+protected:
+	/**
+	 * Deliver or queue a event on the specified game phase depending on the delivery mode
+	 */
+	void DispatchGamePhaseEvent(const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType);
+
+	/**
+	 * Deliver or queue a event for the specified listener only depending on the delivery mode
+	 */
+	void DispatchListenerEvent(int32 ListenerIndex, const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType);
+
+	/**
+	 * Deliver or queue the pending transition depending on the delivery mode
+	 */
+	void DispatchPendingTransition();
+
+	/**
+	 * Notify the specified listener only of a event
+	 */
+	void NotifyListener(int32 ListenerIndex, const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType);
+
 
 	////////////////////////////////////////////////////
 	// Utilities
 public:
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
-	bool SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass);
+	bool SetGamePhase(TSubclassOf<UGamePhase> GamePhaseClass, float Duration = 0.0f);
 
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
 	bool EndGamePhase(FGameplayTag GamePhaseTag);
 
+	/**
+	 * Returns the active game phase instance of the specified tag
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	UGamePhase* FindGamePhase(UPARAM(meta = (Categories = "GamePhase")) FGameplayTag GamePhaseTag) const;
+
+	/**
+	 * Start loading the game phase class and its preload assets in the background
+	 */
+	UFUNCTION(BlueprintCallable, Category = "GamePhase|Prefetch")
+	bool PrefetchGamePhase(TSoftClassPtr<UGamePhase> GamePhaseClass);
+
+	/**
+	 * Returns whether the game phase class and its preload assets have finished loading
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Prefetch")
+	bool IsGamePhasePrefetched(TSoftClassPtr<UGamePhase> GamePhaseClass) const;
+
+	/**
+	 * Returns whether the specified game phase was started locally and is waiting for the server to confirm it
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	bool IsGamePhasePredicted(UPARAM(meta = (Categories = "GamePhase")) FGameplayTag GamePhaseTag) const;
+
+	/**
+	 * Returns the seconds elapsed since the specified game phase started, or -1 if it is not active
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Timing")
+	float GetGamePhaseElapsedTime(UPARAM(meta = (Categories = "GamePhase")) FGameplayTag GamePhaseTag) const;
+
+	/**
+	 * Returns the seconds remaining for the specified game phase, or -1 if it is not active or has no duration
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Timing")
+	float GetGamePhaseRemainingTime(UPARAM(meta = (Categories = "GamePhase")) FGameplayTag GamePhaseTag) const;
+
 
 	////////////////////////////////////////////////////
 	// Game Mode Option
@@ -113,3 +645,18 @@ public:
 	virtual FString ConstructGameModeOption() const;
 
 };
+
+
+/**
+ * Scope to collect all game phase changes made within it into a single transition
+ */
+struct GEPHASE_API FGamePhaseTransitionScope
+{
+public:
+	explicit FGamePhaseTransitionScope(UGamePhaseSubsystem* InSubsystem, bool bHoldEvents = false);
+	~FGamePhaseTransitionScope();
+
+private:
+	TWeakObjectPtr<UGamePhaseSubsystem> Subsystem;
+
+};
@@ -0,0 +1,202 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseGraph.h"
+
+#include "Phase/GamePhase.h"
+#include "GEPhaseLogs.h"
+
+#if WITH_EDITOR
+#include "Misc/DataValidation.h"
+#endif
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GamePhaseGraph)
+
+
+UGamePhaseGraph::UGamePhaseGraph(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+void UGamePhaseGraph::PostLoad()
+{
+	Super::PostLoad();
+
+	CompileGraph();
+}
+
+#if WITH_EDITOR
+void UGamePhaseGraph::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	CompileGraph();
+}
+
+EDataValidationResult UGamePhaseGraph::IsDataValid(FDataValidationContext& Context) const
+{
+	EDataValidationResult Result = CombineDataValidationResults(Super::IsDataValid(Context), EDataValidationResult::Valid);
+
+	TSet<FGameplayTag> NodeTags;
+
+	for (const auto& Node : Nodes)
+	{
+		if (!Node.GamePhaseTag.IsValid())
+		{
+			Result = EDataValidationResult::Invalid;
+
+			Context.AddError(FText::FromString(FString::Printf(TEXT("GamePhaseTag must be set on every node."))));
+		}
+		else if (NodeTags.Contains(Node.GamePhaseTag))
+		{
+			Result = EDataValidationResult::Invalid;
+
+			Context.AddError(FText::FromString(FString::Printf(TEXT("GamePhaseTag (%s) is used by more than one node."), *Node.GamePhaseTag.ToString())));
+		}
+
+		NodeTags.Add(Node.GamePhaseTag);
+	}
+
+	// Transitions to game phases without a node can never be taken
+
+	auto CheckTags
+	{
+		[&](const FGameplayTagContainer& Tags, const FString& Owner)
+		{
+			for (const auto& Tag : Tags)
+			{
+				if (!NodeTags.Contains(Tag))
+				{
+					Result = EDataValidationResult::Invalid;
+
+					Context.AddError(FText::FromString(FString::Printf(TEXT("%s refers to a game phase (%s) that has no node."), *Owner, *Tag.ToString())));
+				}
+			}
+		}
+	};
+
+	for (const auto& Node : Nodes)
+	{
+		CheckTags(Node.NextPhaseTags, Node.GamePhaseTag.ToString());
+		CheckTags(Node.SubPhaseTags, Node.GamePhaseTag.ToString());
+	}
+
+	CheckTags(InitialPhaseTags, TEXT("InitialPhaseTags"));
+
+	return Result;
+}
+#endif
+
+
+void UGamePhaseGraph::CompileGraph()
+{
+	const auto NumNodes{ Nodes.Num() };
+
+	// Give each node its index as its ID
+
+	TagToNodeId.Reset();
+	TagToNodeId.Reserve(NumNodes);
+
+	for (auto NodeId{ 0 }; NodeId < NumNodes; ++NodeId)
+	{
+		const auto& GamePhaseTag{ Nodes[NodeId].GamePhaseTag };
+
+		if (GamePhaseTag.IsValid() && !TagToNodeId.Contains(GamePhaseTag))
+		{
+			TagToNodeId.Add(GamePhaseTag, NodeId);
+		}
+	}
+
+	// Set the bits of the transitions between known nodes
+
+	NextPhaseTable.Init(false, NumNodes * NumNodes);
+	SubPhaseTable.Init(false, NumNodes * NumNodes);
+	InitialPhaseTable.Init(InitialPhaseTags.IsEmpty(), NumNodes);
+
+	auto SetBits
+	{
+		[this](TBitArray<>& Table, int32 RowOffset, const FGameplayTagContainer& Tags)
+		{
+			for (const auto& Tag : Tags)
+			{
+				if (const auto* ToNodeId{ TagToNodeId.Find(Tag) })
+				{
+					Table[RowOffset + *ToNodeId] = true;
+				}
+			}
+		}
+	};
+
+	for (const auto& KVP : TagToNodeId)
+	{
+		const auto& Node{ Nodes[KVP.Value] };
+		const auto RowOffset{ KVP.Value * NumNodes };
+
+		SetBits(NextPhaseTable, RowOffset, Node.NextPhaseTags);
+		SetBits(SubPhaseTable, RowOffset, Node.SubPhaseTags);
+	}
+
+	SetBits(InitialPhaseTable, 0, InitialPhaseTags);
+
+	bCompiled = true;
+
+	UE_LOG(LogGameExt_GamePhase, Log, TEXT("Compiled game phase graph (%s) with %d nodes"), *GetNameSafe(this), TagToNodeId.Num());
+}
+
+int32 UGamePhaseGraph::GetNodeId(const FGameplayTag& InGamePhaseTag) const
+{
+	const auto* NodeId{ TagToNodeId.Find(InGamePhaseTag) };
+
+	return NodeId ? *NodeId : INDEX_NONE;
+}
+
+bool UGamePhaseGraph::CanSetGamePhase(FGameplayTag CurrentPhaseTag, FGameplayTag NewPhaseTag) const
+{
+	ensureMsgf(bCompiled, TEXT("Game phase graph (%s) is used before it is compiled"), *GetNameSafe(this));
+
+	const auto ToNodeId{ GetNodeId(NewPhaseTag) };
+
+	if (ToNodeId == INDEX_NONE)
+	{
+		return false;
+	}
+
+	if (!CurrentPhaseTag.IsValid())
+	{
+		return InitialPhaseTable[ToNodeId];
+	}
+
+	const auto FromNodeId{ GetNodeId(CurrentPhaseTag) };
+
+	return (FromNodeId != INDEX_NONE) && NextPhaseTable[FromNodeId * Nodes.Num() + ToNodeId];
+}
+
+bool UGamePhaseGraph::CanAddSubPhase(FGameplayTag ParentPhaseTag, FGameplayTag SubPhaseTag) const
+{
+	ensureMsgf(bCompiled, TEXT("Game phase graph (%s) is used before it is compiled"), *GetNameSafe(this));
+
+	const auto FromNodeId{ GetNodeId(ParentPhaseTag) };
+	const auto ToNodeId{ GetNodeId(SubPhaseTag) };
+
+	return (FromNodeId != INDEX_NONE) && (ToNodeId != INDEX_NONE) && SubPhaseTable[FromNodeId * Nodes.Num() + ToNodeId];
+}
+
+void UGamePhaseGraph::GetSuccessorClasses(const FGameplayTag& InGamePhaseTag, TArray<TSoftClassPtr<UGamePhase>>& OutClasses) const
+{
+	const auto FromNodeId{ GetNodeId(InGamePhaseTag) };
+
+	if (!bPrefetchSuccessors || (FromNodeId == INDEX_NONE))
+	{
+		return;
+	}
+
+	const auto NumNodes{ Nodes.Num() };
+	const auto RowOffset{ FromNodeId * NumNodes };
+
+	for (auto ToNodeId{ 0 }; ToNodeId < NumNodes; ++ToNodeId)
+	{
+		if ((NextPhaseTable[RowOffset + ToNodeId] || SubPhaseTable[RowOffset + ToNodeId]) && !Nodes[ToNodeId].GamePhaseClass.IsNull())
+		{
+			OutClasses.Add(Nodes[ToNodeId].GamePhaseClass);
+		}
+	}
+}
@@ -0,0 +1,161 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+
+#include "GameplayTagContainer.h"
+
+#include "GamePhaseGraph.generated.h"
+
+class UGamePhase;
+
+
+/**
+ * Transitions allowed from a single game phase
+ */
+USTRUCT(BlueprintType)
+struct GEPHASE_API FGamePhaseGraphNode
+{
+	GENERATED_BODY()
+public:
+	FGamePhaseGraphNode() {}
+
+public:
+	//
+	// Tag of the game phase this node represents
+	//
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "GamePhase", meta = (Categories = "GamePhase"))
+	FGameplayTag GamePhaseTag;
+
+	//
+	// Class of the game phase this node represents
+	// 
+	// Tips:
+	//	Only used to prefetch the game phase before it can be started
+	//
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "GamePhase")
+	TSoftClassPtr<UGamePhase> GamePhaseClass;
+
+	//
+	// Game phases that can replace this game phase
+	//
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "GamePhase", meta = (Categories = "GamePhase"))
+	FGameplayTagContainer NextPhaseTags;
+
+	//
+	// Game phases that can be started as sub-phases of this game phase
+	//
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "GamePhase", meta = (Categories = "GamePhase"))
+	FGameplayTagContainer SubPhaseTags;
+
+};
+
+
+/**
+ * Data asset that declares the transitions allowed between game phases
+ * 
+ * Tips:
+ *	The nodes are compiled on load into tables of bits indexed by node ID, 
+ *	so that whether a transition is allowed can be looked up in constant time.
+ * 
+ * Note:
+ *	Game phases not in the graph can neither be started nor be transitioned from.
+ */
+UCLASS(BlueprintType)
+class GEPHASE_API UGamePhaseGraph : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseGraph(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual EDataValidationResult IsDataValid(class FDataValidationContext& Context) const override;
+#endif
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Nodes
+protected:
+	//
+	// Game phases of this graph and the transitions allowed from each of them
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Graph", meta = (TitleProperty = "GamePhaseTag"))
+	TArray<FGamePhaseGraphNode> Nodes;
+
+	//
+	// Game phases that can be set when no game phase is active
+	// 
+	// Tips:
+	//	If empty, any game phase in the graph can be set first
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Graph", meta = (Categories = "GamePhase"))
+	FGameplayTagContainer InitialPhaseTags;
+
+	//
+	// Whether to prefetch the game phases that can follow each game phase when it starts
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Prefetch")
+	bool bPrefetchSuccessors{ true };
+
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Compiled Table
+protected:
+	//
+	// Node ID for each game phase tag
+	//
+	TMap<FGameplayTag, int32> TagToNodeId;
+
+	//
+	// Bits of the allowed transitions, indexed by (FromNodeId * NumNodes + ToNodeId)
+	//
+	TBitArray<> NextPhaseTable;
+	TBitArray<> SubPhaseTable;
+
+	//
+	// Bits of the game phases that can be set first, indexed by node ID
+	//
+	TBitArray<> InitialPhaseTable;
+
+	bool bCompiled{ false };
+
+public:
+	/**
+	 * Compile the nodes into the lookup tables
+	 * 
+	 * Tips:
+	 *	Called automatically on load. Must be called after changing the nodes of a graph created at runtime.
+	 */
+	void CompileGraph();
+
+	bool IsCompiled() const { return bCompiled; }
+
+	/**
+	 * Returns the node ID of the game phase, or INDEX_NONE if it is not in the graph
+	 */
+	int32 GetNodeId(const FGameplayTag& InGamePhaseTag) const;
+
+	/**
+	 * Returns whether the game phase can replace the current game phase
+	 * 
+	 * Tips:
+	 *	An empty current tag means that no game phase is active
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	bool CanSetGamePhase(FGameplayTag CurrentPhaseTag, FGameplayTag NewPhaseTag) const;
+
+	/**
+	 * Returns whether the game phase can be started as a sub-phase of the parent phase
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase")
+	bool CanAddSubPhase(FGameplayTag ParentPhaseTag, FGameplayTag SubPhaseTag) const;
+
+	/**
+	 * Returns the classes of the game phases that can follow the game phase if successors should be prefetched
+	 */
+	void GetSuccessorClasses(const FGameplayTag& InGamePhaseTag, TArray<TSoftClassPtr<UGamePhase>>& OutClasses) const;
+
+};
@@ -3,28 +3,46 @@
 #include "ActiveGamePhase.h"
 
 #include "GamePhaseSubsystem.h"
+#include "GamePhaseComponent.h"
 #include "GamePhase.h"
+#include "Registry/GamePhaseClassRegistry.h"
+#include "Graph/GamePhaseGraph.h"
 #include "GEPhaseLogs.h"
+#include "GEPhaseStats.h"
 
 #include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/NetConnection.h"
+#include "Engine/PackageMapClient.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(ActiveGamePhase)
 
 
+DECLARE_CYCLE_STAT(TEXT("Set Game Phase"), STAT_GamePhase_SetGamePhase, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("Add Sub Phase"), STAT_GamePhase_AddSubPhase, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("End Phase By Tag"), STAT_GamePhase_EndPhaseByTag, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("End All Game Phases"), STAT_GamePhase_EndAllGamePhases, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("Replicated Add"), STAT_GamePhase_ReplicatedAdd, STATGROUP_GamePhase);
+DECLARE_CYCLE_STAT(TEXT("Replicated Remove"), STAT_GamePhase_ReplicatedRemove, STATGROUP_GamePhase);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Game Phases"), STAT_GamePhase_NumActiveGamePhases, STATGROUP_GamePhase);
+
+
 //////////////////////////////////////////////////////
 // FActiveGamePhase
 
 #pragma region FActiveGamePhase
 
-const FGameplayTag& FActiveGamePhase::GetGamePhaseTag() const
+bool FActiveGamePhase::CacheGamePhaseTag()
 {
-	return Class.GetDefaultObject()->GetGamePhaseTag();
+	GamePhaseTag = Class ? Class.GetDefaultObject()->GetGamePhaseTag() : FGameplayTag::EmptyTag;
+
+	return GamePhaseTag.IsValid();
 }
 
 FString FActiveGamePhase::GetDebugString() const
 {
-	return FString::Printf(TEXT("(Class:%s, Instance:%s)"),
-		*GetNameSafe(Class), *GetNameSafe(Instance));
+	return FString::Printf(TEXT("(Class:%s, NetId:%u, Tag:%s, Instance:%s)"),
+		*GetNameSafe(Class), ClassNetId, *GamePhaseTag.ToString(), *GetNameSafe(Instance));
 }
 
 #pragma endregion
@@ -44,37 +62,318 @@ void FActiveGamePhaseContainer::RegisterOwner(AGameStateBase* InOwner, UGamePhas
 
 void FActiveGamePhaseContainer::PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize)
 {
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_ReplicatedRemove);
+
 	check(Owner);
 	check(OwnerComponent);
 
-	for (const auto& Index : RemovedIndices)
+	BeginReplicatedBatch();
+
+	// Remove in reverse server order so that sub-phases end before their parent
+
+	TArray<int32, TInlineAllocator<8>> SortedIndices{ RemovedIndices };
+
+	SortedIndices.Sort(
+		[this](int32 A, int32 B)
+		{
+			return Entries[A].SequenceNumber > Entries[B].SequenceNumber;
+		}
+	);
+
+	for (const auto& Index : SortedIndices)
 	{
 		auto& Entry{ Entries[Index] };
+		const auto GamePhaseTag{ Entry.GetGamePhaseTag() };
+
+		DeferredReplicationIDs.RemoveSingleSwap(Entry.ReplicationID);
+		LoadingReplicationIDs.RemoveSingleSwap(Entry.ReplicationID);
+
+		// Skip entries whose class could not be resolved or whose parent never arrived
+
+		if (Entry.Instance)
+		{
+			HandleGamePhaseRemove(Entry);
+		}
 
-		HandleGamePhaseRemove(Entry);
+		// Predicted sub-phases can no longer be confirmed once their parent has ended
+
+		RollbackPredictionsOfParent(GamePhaseTag);
 	}
+
+	// Entries are removed by the serializer after this, so the indices are rebuilt on next use without them
+
+	PendingRemovedIndices.Append(RemovedIndices);
+
+	bEntryIndexStale = true;
 }
 
 void FActiveGamePhaseContainer::PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize)
 {
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_ReplicatedAdd);
+
 	check(Owner);
 	check(OwnerComponent);
 
+	BeginReplicatedBatch();
+
+	// Resolve classes and tags of the added entries once
+
+	TArray<int32, TInlineAllocator<8>> ResolvedIndices;
+	TArray<FSoftObjectPath> ClassPathsToLoad;
+
 	for (const auto& Index : AddedIndices)
 	{
 		auto& Entry{ Entries[Index] };
 
+		// Entries whose classes are not loaded yet are started once loading has finished
+
+		if (!ReadNetIds(Entry, ClassPathsToLoad))
+		{
+			LoadingReplicationIDs.Add(Entry.ReplicationID);
+			continue;
+		}
+
+		Entry.CacheGamePhaseTag();
+		ResolvedIndices.Add(Index);
+	}
+
+	HandleReplicatedEntriesAdded(ResolvedIndices);
+
+	if (!ClassPathsToLoad.IsEmpty())
+	{
+		OwnerComponent->LoadReplicatedGamePhaseClasses(MoveTemp(ClassPathsToLoad));
+	}
+}
+
+void FActiveGamePhaseContainer::HandleReplicatedEntriesAdded(const TArrayView<const int32> AddedIndices)
+{
+	// Added entries must be indexed before being handled so that sub-phases can find their parent
+
+	RebuildEntryIndex();
+
+	// Add in server order together with the sub-phases deferred in previous updates, so that parents start before their sub-phases
+
+	TArray<int32, TInlineAllocator<8>> SortedIndices{ AddedIndices };
+
+	for (const auto& ReplicationID : DeferredReplicationIDs)
+	{
+		const auto DeferredIndex
+		{
+			Entries.IndexOfByPredicate(
+				[ReplicationID](const FActiveGamePhase& Entry)
+				{
+					return Entry.ReplicationID == ReplicationID;
+				}
+			)
+		};
+
+		if (DeferredIndex != INDEX_NONE)
+		{
+			SortedIndices.AddUnique(DeferredIndex);
+		}
+	}
+
+	DeferredReplicationIDs.Reset();
+
+	SortedIndices.Sort(
+		[this](int32 A, int32 B)
+		{
+			return Entries[A].SequenceNumber < Entries[B].SequenceNumber;
+		}
+	);
+
+	for (const auto& Index : SortedIndices)
+	{
+		auto& Entry{ Entries[Index] };
+
+		if (!Entry.Class)
+		{
+			UE_LOG(LogGameExt_GamePhase, Error, TEXT("Failed to resolve replicated game phase class: %s"), *Entry.GetDebugString());
+			continue;
+		}
+
+		// Wait for the parent if it has not been started yet
+
+		if (Entry.ParentPhaseTag.IsValid())
+		{
+			const auto ParentIndex{ FindEntryIndexByTag(Entry.ParentPhaseTag) };
+
+			if ((ParentIndex == INDEX_NONE) || !Entries[ParentIndex].Instance)
+			{
+				DeferredReplicationIDs.Add(Entry.ReplicationID);
+				continue;
+			}
+		}
+
+		// Take over the predicted instance without starting it again
+
+		if (ConfirmPrediction(Entry))
+		{
+			continue;
+		}
+
 		HandleGamePhaseAdd(Entry);
 	}
 }
 
+void FActiveGamePhaseContainer::HandleReplicatedClassesLoaded()
+{
+	if (LoadingReplicationIDs.IsEmpty())
+	{
+		return;
+	}
+
+	check(Owner);
+	check(OwnerComponent);
+
+	// Notify the game phases started by this load as a single transition
+
+	FGamePhaseTransitionScope TransitionScope{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) };
+
+	// Entries that are still unresolved wait for the other loads in progress, or fail if there are none
+
+	const auto bStillLoading{ OwnerComponent->IsLoadingReplicatedGamePhaseClasses() };
+
+	TArray<FSoftObjectPath> StillLoadingClassPaths;
+
+	for (auto Idx{ LoadingReplicationIDs.Num() - 1 }; Idx >= 0; --Idx)
+	{
+		const auto ReplicationID{ LoadingReplicationIDs[Idx] };
+
+		const auto EntryIndex
+		{
+			Entries.IndexOfByPredicate(
+				[ReplicationID](const FActiveGamePhase& Entry)
+				{
+					return Entry.ReplicationID == ReplicationID;
+				}
+			)
+		};
+
+		if (EntryIndex == INDEX_NONE)
+		{
+			LoadingReplicationIDs.RemoveAtSwap(Idx);
+			continue;
+		}
+
+		auto& Entry{ Entries[EntryIndex] };
+
+		if (ReadNetIds(Entry, StillLoadingClassPaths) || !bStillLoading)
+		{
+			Entry.CacheGamePhaseTag();
+
+			DeferredReplicationIDs.Add(ReplicationID);
+			LoadingReplicationIDs.RemoveAtSwap(Idx);
+		}
+	}
+
+	HandleReplicatedEntriesAdded(TArrayView<const int32>());
+}
+
 void FActiveGamePhaseContainer::PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize)
 {
+	// Only the timing of an entry changes after it is added
+
+	for (const auto& Index : ChangedIndices)
+	{
+		auto& ActiveGamePhase{ Entries[Index] };
+
+		if (ActiveGamePhase.Instance)
+		{
+			ActiveGamePhase.Instance->InitializeTiming(ActiveGamePhase.ServerStartTime, ActiveGamePhase.Duration, ActiveGamePhase.ServerPauseTime);
+		}
+	}
+}
+
+void FActiveGamePhaseContainer::PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters)
+{
+	// Removed entries are gone now, so the indices built without them are rebuilt on next use
+
+	if (!PendingRemovedIndices.IsEmpty())
+	{
+		PendingRemovedIndices.Reset();
+
+		bEntryIndexStale = true;
+	}
+
+	// Notify all changes received in this update as a single transition
+
+	if (bReceivingReplicatedBatch)
+	{
+		bReceivingReplicatedBatch = false;
+
+		if (auto* Subsystem{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) })
+		{
+			Subsystem->EndGamePhaseTransition();
+		}
+	}
+}
+
+void FActiveGamePhaseContainer::RefreshRelevancy()
+{
+	MarkEntriesDirty();
+}
+
+const APlayerController* FActiveGamePhaseContainer::GetReplicatingPlayer(const FNetDeltaSerializeInfo& DeltaParms)
+{
+	if (DeltaParms.bIsWritingOnClient || !DeltaParms.Writer)
+	{
+		return nullptr;
+	}
+
+	auto* PackageMap{ Cast<UPackageMapClient>(DeltaParms.Map) };
+	const auto* Connection{ PackageMap ? PackageMap->GetConnection() : nullptr };
+
+	return Connection ? Connection->PlayerController : nullptr;
+}
+
+bool FActiveGamePhaseContainer::IsEntryRelevantToPlayer(const FActiveGamePhase& Entry, const APlayerController* PlayerController) const
+{
+	// Connections without a player, such as replays, only see the game phases for all players
+
+	if (!PlayerController)
+	{
+		return false;
+	}
+
+	// Walk up while the parent phases are also for relevant players only
+
+	for (const auto* Each{ &Entry }; Each && Each->bRelevantPlayersOnly; )
+	{
+		if (Each->Class && (Each->Class.GetDefaultObject()->GetReplicationPolicy() == EGamePhaseReplicationPolicy::RelevantPlayersOnly))
+		{
+			if (!Each->Instance || !Each->Instance->IsRelevantToPlayer(PlayerController))
+			{
+				return false;
+			}
+		}
+
+		const auto ParentIndex{ Each->ParentPhaseTag.IsValid() ? FindEntryIndexByTag(Each->ParentPhaseTag) : INDEX_NONE };
+
+		Each = Entries.IsValidIndex(ParentIndex) ? &Entries[ParentIndex] : nullptr;
+	}
+
+	return true;
+}
+
+void FActiveGamePhaseContainer::BeginReplicatedBatch()
+{
+	if (!bReceivingReplicatedBatch)
+	{
+		if (auto* Subsystem{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) })
+		{
+			bReceivingReplicatedBatch = true;
+
+			Subsystem->BeginGamePhaseTransition();
+		}
+	}
 }
 
 
-bool FActiveGamePhaseContainer::SetGamePhase(const TSubclassOf<UGamePhase>& GamePhaseClass)
+bool FActiveGamePhaseContainer::SetGamePhase(const TSubclassOf<UGamePhase>& GamePhaseClass, float Duration)
 {
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_SetGamePhase);
+
 	check(Owner);
 	check(OwnerComponent);
 
@@ -87,29 +386,75 @@ bool FActiveGamePhaseContainer::SetGamePhase(const TSubclassOf<UGamePhase>& Game
 
 	// Early out if phase already started
 
-	for (const auto& Entry : Entries)
+	if (FindEntryIndexByClass(GamePhaseClass) != INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Early out if class has no valid tag
+
+	FActiveGamePhase NewEntry(GamePhaseClass, (Duration > 0.0f) ? Duration : GamePhaseClass.GetDefaultObject()->GetDefaultDuration());
+
+	if (!NewEntry.CacheGamePhaseTag())
+	{
+		UE_LOG(LogGameExt_GamePhase, Error, TEXT("Game phase class has no valid GamePhaseTag: %s"), *GetNameSafe(GamePhaseClass));
+		return false;
+	}
+
+	// Early out if another class with the same tag already started, such as a blueprint subclass sharing the tag of its parent
+
+	if (FindEntryIndexByTag(NewEntry.GetGamePhaseTag()) != INDEX_NONE)
+	{
+		UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Game phase with the same GamePhaseTag is already active: %s (%s)"), *NewEntry.GetGamePhaseTag().ToString(), *GetNameSafe(GamePhaseClass));
+		return false;
+	}
+
+	// Early out if the transition graph does not allow it
+
+	if (const auto* Graph{ OwnerComponent->GetGamePhaseGraph() })
 	{
-		if (GamePhaseClass == Entry.Class)
+		const auto CurrentPhaseTag{ GetCurrentGamePhaseTag() };
+
+		if (!Graph->CanSetGamePhase(CurrentPhaseTag, NewEntry.GetGamePhaseTag()))
 		{
+			UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Game phase transition is not allowed by graph (%s): %s -> %s")
+				, *GetNameSafe(Graph), *CurrentPhaseTag.ToString(), *NewEntry.GetGamePhaseTag().ToString());
 			return false;
 		}
 	}
 
+	// Notify ending of old game phases and starting of new game phase as a single transition
+
+	FGamePhaseTransitionScope TransitionScope{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) };
+
+	// Mark the array dirty once for the removals and the addition
+
+	BeginBatch();
+
 	// End old game phases
 
 	EndAllPhase();
 
 	// Create new active game phase
 
-	auto& NewGamePhase{ Entries.Emplace_GetRef(GamePhaseClass)};
-	HandleGamePhaseAdd(NewGamePhase);
-	MarkItemDirty(NewGamePhase);
+	WriteNetIds(NewEntry);
+	NewEntry.ServerStartTime = Owner->GetServerWorldTimeSeconds();
+
+	// Mark dirty before the start notifications, since they may add or end game phases and move the entry
+
+	const auto NewIndex{ AddEntry(MoveTemp(NewEntry)) };
+	MarkEntryDirty(Entries[NewIndex]);
+	HandleGamePhaseAdd(Entries[NewIndex]);
+
+	EndBatch();
 
 	return true;
 }
 
-bool FActiveGamePhaseContainer::AddSubPhase(const TSubclassOf<UGamePhase>& GamePhaseClass, const FGameplayTag& InParentPhaseTag)
+bool FActiveGamePhaseContainer::AddSubPhase(const TSubclassOf<UGamePhase>& GamePhaseClass, const FGameplayTag& InParentPhaseTag, float Duration)
 {
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_AddSubPhase);
+
 	check(Owner);
 	check(OwnerComponent);
 
@@ -129,25 +474,59 @@ bool FActiveGamePhaseContainer::AddSubPhase(const TSubclassOf<UGamePhase>& GameP
 
 	// Early out if phase already started
 
-	for (const auto& Entry : Entries)
+	if (FindEntryIndexByClass(GamePhaseClass) != INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Early out if class has no valid tag
+
+	FActiveGamePhase NewEntry(GamePhaseClass, InParentPhaseTag, (Duration > 0.0f) ? Duration : GamePhaseClass.GetDefaultObject()->GetDefaultDuration());
+
+	if (!NewEntry.CacheGamePhaseTag())
+	{
+		UE_LOG(LogGameExt_GamePhase, Error, TEXT("Game phase class has no valid GamePhaseTag: %s"), *GetNameSafe(GamePhaseClass));
+		return false;
+	}
+
+	// Early out if another class with the same tag already started, such as a blueprint subclass sharing the tag of its parent
+
+	if (FindEntryIndexByTag(NewEntry.GetGamePhaseTag()) != INDEX_NONE)
+	{
+		UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Game phase with the same GamePhaseTag is already active: %s (%s)"), *NewEntry.GetGamePhaseTag().ToString(), *GetNameSafe(GamePhaseClass));
+		return false;
+	}
+
+	// Early out if the transition graph does not allow it
+
+	if (const auto* Graph{ OwnerComponent->GetGamePhaseGraph() })
 	{
-		if (GamePhaseClass == Entry.Class)
+		if (!Graph->CanAddSubPhase(InParentPhaseTag, NewEntry.GetGamePhaseTag()))
 		{
+			UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Sub-phase is not allowed by graph (%s): %s -> %s")
+				, *GetNameSafe(Graph), *InParentPhaseTag.ToString(), *NewEntry.GetGamePhaseTag().ToString());
 			return false;
 		}
 	}
 
 	// create new active sub phase
 
-	auto& NewGamePhase{ Entries.Emplace_GetRef(GamePhaseClass, InParentPhaseTag) };
-	HandleGamePhaseAdd(NewGamePhase);
-	MarkItemDirty(NewGamePhase);
+	WriteNetIds(NewEntry);
+	NewEntry.ServerStartTime = Owner->GetServerWorldTimeSeconds();
+
+	// Mark dirty before the start notifications, since they may add or end game phases and move the entry
+
+	const auto NewIndex{ AddEntry(MoveTemp(NewEntry)) };
+	MarkEntryDirty(Entries[NewIndex]);
+	HandleGamePhaseAdd(Entries[NewIndex]);
 
 	return true;
 }
 
 bool FActiveGamePhaseContainer::EndPhaseByTag(const FGameplayTag& InGamePhaseTag)
 {
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_EndPhaseByTag);
+
 	check(Owner);
 	check(OwnerComponent);
 
@@ -160,22 +539,50 @@ bool FActiveGamePhaseContainer::EndPhaseByTag(const FGameplayTag& InGamePhaseTag
 
 	// Look for game phase and exit if it was a sub-phase
 
-	for (auto It{ Entries.CreateIterator() }; It; ++It)
+	const auto EntryIndex{ FindEntryIndexByTag(InGamePhaseTag) };
+
+	if ((EntryIndex == INDEX_NONE) || !Entries[EntryIndex].ParentPhaseTag.IsValid())
+	{
+		return false;
+	}
+
+	// End the sub-phase together with its own sub-phases as a single transition
+
+	FGamePhaseTagArray Subtree;
+	CollectSubtreeDeepestFirst(InGamePhaseTag, Subtree);
+
 	{
-		auto& Entry{ *It };
+		FGamePhaseTransitionScope TransitionScope{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) };
 
-		if ((Entry.GetGamePhaseTag() == InGamePhaseTag) && Entry.ParentPhaseTag.IsValid())
-		{
-			HandleGamePhaseRemove(Entry);
-			It.RemoveCurrent();
+		RemovePhases(Subtree);
+	}
 
-			MarkArrayDirty();
+	MarkEntriesDirty();
 
-			return true;
-		}
+	return true;
+}
+
+bool FActiveGamePhaseContainer::EndAllGamePhases()
+{
+	SCOPE_CYCLE_COUNTER(STAT_GamePhase_EndAllGamePhases);
+
+	check(Owner);
+	check(OwnerComponent);
+
+	// Suspend if no game phase is active
+
+	if (Entries.IsEmpty())
+	{
+		return false;
 	}
 
-	return false;
+	// End all game phases as a single transition
+
+	FGamePhaseTransitionScope TransitionScope{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) };
+
+	EndAllPhase();
+
+	return true;
 }
 
 TSubclassOf<UGamePhase> FActiveGamePhaseContainer::GetCurrentGamePhaseClass() const
@@ -191,62 +598,865 @@ TSubclassOf<UGamePhase> FActiveGamePhaseContainer::GetCurrentGamePhaseClass() co
 	return nullptr;
 }
 
-
-
-void FActiveGamePhaseContainer::EndAllPhase()
+FGameplayTag FActiveGamePhaseContainer::GetCurrentGamePhaseTag() const
 {
-	for (auto& Entry : Entries)
+	for (const auto& Entry : Entries)
 	{
-		HandleGamePhaseRemove(Entry);
+		if (!Entry.ParentPhaseTag.IsValid())
+		{
+			return Entry.GetGamePhaseTag();
+		}
 	}
 
-	Entries.Empty();
+	return FGameplayTag::EmptyTag;
+}
 
-	MarkArrayDirty();
+void FActiveGamePhaseContainer::GetActiveGamePhaseTags(TArray<FGameplayTag>& OutGamePhaseTags) const
+{
+	for (const auto& Entry : Entries)
+	{
+		if (Entry.GetGamePhaseTag().IsValid())
+		{
+			OutGamePhaseTags.Add(Entry.GetGamePhaseTag());
+		}
+	}
 }
 
-void FActiveGamePhaseContainer::HandleGamePhaseAdd(FActiveGamePhase& ActiveGamePhase)
+UGamePhase* FActiveGamePhaseContainer::FindGamePhaseByTag(const FGameplayTag& InGamePhaseTag) const
 {
-	// Create new instance
+	const auto EntryIndex{ FindEntryIndexByTag(InGamePhaseTag) };
 
-	ActiveGamePhase.Instance = NewObject<UGamePhase>(Owner.Get(), ActiveGamePhase.Class);
-	check(ActiveGamePhase.Instance);
+	if (EntryIndex != INDEX_NONE)
+	{
+		return Entries[EntryIndex].Instance.Get();
+	}
 
-	// Handle start
+	const auto PredictionIndex{ FindPredictionIndexByTag(InGamePhaseTag) };
 
-	ActiveGamePhase.Instance->InitializeGamePhase(Owner.Get(), OwnerComponent.Get());
-	ActiveGamePhase.Instance->HandleGamePhaseStart();
+	return (PredictionIndex != INDEX_NONE) ? PredictedPhases[PredictionIndex].Instance.Get() : nullptr;
+}
 
-	// Notify subsystem
+FGameplayTag FActiveGamePhaseContainer::GetParentPhaseTag(const FGameplayTag& InGamePhaseTag) const
+{
+	const auto EntryIndex{ FindEntryIndexByTag(InGamePhaseTag) };
 
-	const auto& GamePhaseTag{ ActiveGamePhase.GetGamePhaseTag() };
+	return (EntryIndex != INDEX_NONE) ? Entries[EntryIndex].ParentPhaseTag : FGameplayTag::EmptyTag;
+}
 
-	if (auto* Subsystem{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) })
-	{
-		Subsystem->AddGamePhaseTag(GamePhaseTag);
-	}
+bool FActiveGamePhaseContainer::SetGamePhaseTimerPaused(const FGameplayTag& InGamePhaseTag, bool bPaused)
+{
+	check(Owner);
 
-	// Notifies that a subphase has started if there is a parent game phase
+	const auto EntryIndex{ FindEntryIndexByTag(InGamePhaseTag) };
 
-	if (ActiveGamePhase.ParentPhaseTag.IsValid())
+	if (EntryIndex == INDEX_NONE)
 	{
-		HandleSubPhaseStart(ActiveGamePhase.ParentPhaseTag, GamePhaseTag);
+		return false;
 	}
+
+	auto& Entry{ Entries[EntryIndex] };
+
+	// Suspend if the game phase has no duration or the timer is already in that state
+
+	if ((Entry.Duration <= 0.0f) || ((Entry.ServerPauseTime > 0.0) == bPaused))
+	{
+		return false;
+	}
+
+	const auto ServerTime{ Owner->GetServerWorldTimeSeconds() };
+
+	// Shift the start time by the paused time so that the elapsed time excludes it
+
+	if (bPaused)
+	{
+		Entry.ServerPauseTime = ServerTime;
+	}
+	else
+	{
+		Entry.ServerStartTime += ServerTime - Entry.ServerPauseTime;
+		Entry.ServerPauseTime = 0.0;
+	}
+
+	if (Entry.Instance)
+	{
+		Entry.Instance->InitializeTiming(Entry.ServerStartTime, Entry.Duration, Entry.ServerPauseTime);
+	}
+
+	MarkEntryDirty(Entry);
+
+	return true;
+}
+
+
+bool FActiveGamePhaseContainer::PredictSubPhase(const TSubclassOf<UGamePhase>& GamePhaseClass, const FGameplayTag& InParentPhaseTag, float Duration)
+{
+	check(Owner);
+	check(OwnerComponent);
+
+	// Suspend if class or tag is not valid
+
+	if (!GamePhaseClass || !InParentPhaseTag.IsValid())
+	{
+		return false;
+	}
+
+	// Server-only game phases are never confirmed on clients
+
+	if (GamePhaseClass.GetDefaultObject()->GetReplicationPolicy() == EGamePhaseReplicationPolicy::ServerOnly)
+	{
+		return false;
+	}
+
+	const auto& GamePhaseTag{ GamePhaseClass.GetDefaultObject()->GetGamePhaseTag() };
+
+	if (!GamePhaseTag.IsValid())
+	{
+		UE_LOG(LogGameExt_GamePhase, Error, TEXT("Game phase class has no valid GamePhaseTag: %s"), *GetNameSafe(GamePhaseClass));
+		return false;
+	}
+
+	// Early out if phase or another phase with the same tag already started or predicted
+
+	if ((FindEntryIndexByClass(GamePhaseClass) != INDEX_NONE) || (FindEntryIndexByTag(GamePhaseTag) != INDEX_NONE) || (FindPredictionIndexByTag(GamePhaseTag) != INDEX_NONE))
+	{
+		return false;
+	}
+
+	// Suspend if parent phase is not active
+
+	if (FindEntryIndexByTag(InParentPhaseTag) == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Suspend if the transition graph does not allow it
+
+	if (const auto* Graph{ OwnerComponent->GetGamePhaseGraph() })
+	{
+		if (!Graph->CanAddSubPhase(InParentPhaseTag, GamePhaseTag))
+		{
+			return false;
+		}
+	}
+
+	// Start predicted instance
+
+	auto& NewPrediction{ PredictedPhases.AddDefaulted_GetRef() };
+	NewPrediction.Class = GamePhaseClass;
+	NewPrediction.GamePhaseTag = GamePhaseTag;
+	NewPrediction.ParentPhaseTag = InParentPhaseTag;
+	NewPrediction.PredictionTime = Owner->GetWorld()->GetTimeSeconds();
+	NewPrediction.Instance = OwnerComponent->AcquireGamePhaseInstance(GamePhaseClass);
+	check(NewPrediction.Instance);
+
+	auto* Instance{ NewPrediction.Instance.Get() };
+
+	Instance->InitializeGamePhase(Owner.Get(), OwnerComponent.Get());
+	Instance->InitializeTiming(Owner->GetServerWorldTimeSeconds(), (Duration > 0.0f) ? Duration : GamePhaseClass.GetDefaultObject()->GetDefaultDuration());
+	Instance->HandleGamePhaseStart();
+
+	if (auto* Subsystem{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) })
+	{
+		Subsystem->AddGamePhaseTag(GamePhaseTag);
+	}
+
+	HandleSubPhaseStart(InParentPhaseTag, GamePhaseTag);
+
+	return true;
+}
+
+bool FActiveGamePhaseContainer::IsGamePhasePredicted(const FGameplayTag& InGamePhaseTag) const
+{
+	return FindPredictionIndexByTag(InGamePhaseTag) != INDEX_NONE;
+}
+
+double FActiveGamePhaseContainer::RollbackExpiredPredictions(double ExpireBeforeTime)
+{
+	auto OldestTime{ -1.0 };
+
+	for (auto Idx{ PredictedPhases.Num() - 1 }; Idx >= 0; --Idx)
+	{
+		if (!PredictedPhases.IsValidIndex(Idx))
+		{
+			continue;
+		}
+
+		const auto PredictionTime{ PredictedPhases[Idx].PredictionTime };
+
+		if (PredictionTime < ExpireBeforeTime)
+		{
+			RollbackPredictionAt(Idx);
+		}
+		else if ((OldestTime < 0.0) || (PredictionTime < OldestTime))
+		{
+			OldestTime = PredictionTime;
+		}
+	}
+
+	return OldestTime;
+}
+
+void FActiveGamePhaseContainer::RollbackAllPredictions()
+{
+	while (!PredictedPhases.IsEmpty())
+	{
+		RollbackPredictionAt(PredictedPhases.Num() - 1);
+	}
+}
+
+int32 FActiveGamePhaseContainer::FindPredictionIndexByTag(const FGameplayTag& InGamePhaseTag) const
+{
+	// Only a few predictions exist at a time
+
+	return PredictedPhases.IndexOfByPredicate(
+		[&InGamePhaseTag](const FPredictedGamePhase& Prediction)
+		{
+			return Prediction.GamePhaseTag == InGamePhaseTag;
+		}
+	);
+}
+
+bool FActiveGamePhaseContainer::ConfirmPrediction(FActiveGamePhase& ActiveGamePhase)
+{
+	const auto PredictionIndex{ FindPredictionIndexByTag(ActiveGamePhase.GetGamePhaseTag()) };
+
+	if (PredictionIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Roll back if the server started it differently
+
+	const auto& Prediction{ PredictedPhases[PredictionIndex] };
+
+	if ((Prediction.Class != ActiveGamePhase.Class) || (Prediction.ParentPhaseTag != ActiveGamePhase.ParentPhaseTag))
+	{
+		RollbackPredictionAt(PredictionIndex);
+		return false;
+	}
+
+	// Adopt the instance with the timing decided by the server
+
+	INC_DWORD_STAT(STAT_GamePhase_NumActiveGamePhases);
+
+	ActiveGamePhase.Instance = Prediction.Instance;
+	ActiveGamePhase.Instance->InitializeTiming(ActiveGamePhase.ServerStartTime, ActiveGamePhase.Duration, ActiveGamePhase.ServerPauseTime);
+
+	PredictedPhases.RemoveAtSwap(PredictionIndex);
+
+	return true;
+}
+
+void FActiveGamePhaseContainer::RollbackPredictionAt(int32 PredictionIndex)
+{
+	// Take out first since ending the instance may change the predictions
+
+	auto Prediction{ MoveTemp(PredictedPhases[PredictionIndex]) };
+	PredictedPhases.RemoveAtSwap(PredictionIndex);
+
+	UE_LOG(LogGameExt_GamePhase, Log, TEXT("Predicted game phase rolled back: %s"), *Prediction.GamePhaseTag.ToString());
+
+	if (Prediction.Instance)
+	{
+		Prediction.Instance->HandleGamePhaseEnd();
+	}
+
+	if (auto* Subsystem{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) })
+	{
+		Subsystem->RemoveGamePhaseTag(Prediction.GamePhaseTag);
+	}
+
+	HandleSubPhaseEnd(Prediction.ParentPhaseTag, Prediction.GamePhaseTag);
+
+	OwnerComponent->ReleaseGamePhaseInstance(Prediction.Instance);
+}
+
+void FActiveGamePhaseContainer::RollbackPredictionsOfParent(const FGameplayTag& InParentPhaseTag)
+{
+	for (auto Idx{ PredictedPhases.Num() - 1 }; Idx >= 0; --Idx)
+	{
+		if (PredictedPhases.IsValidIndex(Idx) && (PredictedPhases[Idx].ParentPhaseTag == InParentPhaseTag))
+		{
+			RollbackPredictionAt(Idx);
+		}
+	}
+}
+
+
+void FActiveGamePhaseContainer::EndAllPhase()
+{
+	// End each root game phase together with its sub-phases, deepest first
+
+	FGamePhaseTagArray AllPhases;
+
+	for (const auto& Entry : Entries)
+	{
+		if (!Entry.ParentPhaseTag.IsValid() || (FindEntryIndexByTag(Entry.ParentPhaseTag) == INDEX_NONE))
+		{
+			CollectSubtreeDeepestFirst(Entry.GetGamePhaseTag(), AllPhases);
+		}
+	}
+
+	RemovePhases(AllPhases);
+
+	// Discard entries that could not be reached, such as those whose class was not resolved.
+	// The memory is kept for the game phases that start next.
+
+	Entries.Reset();
+	TagToEntryIndex.Reset();
+	ClassToEntryIndex.Reset();
+	ChildPhaseTags.Reset();
+	bEntryIndexStale = false;
+
+	MarkEntriesDirty();
+}
+
+void FActiveGamePhaseContainer::CollectSubtreeDeepestFirst(const FGameplayTag& InGamePhaseTag, FGamePhaseTagArray& OutGamePhaseTags) const
+{
+	if (const auto* Children{ ChildPhaseTags.Find(InGamePhaseTag) })
+	{
+		for (auto Idx{ Children->Num() - 1 }; Idx >= 0; --Idx)
+		{
+			CollectSubtreeDeepestFirst((*Children)[Idx], OutGamePhaseTags);
+		}
+	}
+
+	OutGamePhaseTags.Add(InGamePhaseTag);
+}
+
+void FActiveGamePhaseContainer::RemovePhases(const FGamePhaseTagArray& GamePhaseTags)
+{
+	for (const auto& GamePhaseTag : GamePhaseTags)
+	{
+		// Look up each time since the entries may change during the end notifications
+
+		const auto EntryIndex{ FindEntryIndexByTag(GamePhaseTag) };
+
+		if (EntryIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		HandleGamePhaseRemove(Entries[EntryIndex]);
+
+		const auto RemoveIndex{ FindEntryIndexByTag(GamePhaseTag) };
+
+		if (RemoveIndex != INDEX_NONE)
+		{
+			RemoveEntryAt(RemoveIndex);
+		}
+	}
+}
+
+void FActiveGamePhaseContainer::MarkEntryDirty(FActiveGamePhase& Entry)
+{
+	MarkItemDirty(Entry);
+
+	if (BatchDepth > 0)
+	{
+		bBatchDirty = true;
+		return;
+	}
+
+	OwnerComponent->MarkActiveGamePhasesDirty();
+}
+
+void FActiveGamePhaseContainer::MarkEntriesDirty()
+{
+	if (BatchDepth > 0)
+	{
+		bBatchDirty = true;
+		return;
+	}
+
+	MarkArrayDirty();
+
+	OwnerComponent->MarkActiveGamePhasesDirty();
+}
+
+
+bool FActiveGamePhaseContainer::ValidateTransaction(const TArray<FGamePhaseTransactionOp>& Ops) const
+{
+	// Simulate the game phases as parent tag and class for each tag
+
+	struct FSimulatedPhase
+	{
+		FGameplayTag ParentPhaseTag;
+		const UClass* Class{ nullptr };
+	};
+
+	TMap<FGameplayTag, FSimulatedPhase> SimulatedPhases;
+	TSet<const UClass*> SimulatedClasses;
+	auto SimulatedCurrentPhaseTag{ GetCurrentGamePhaseTag() };
+
+	for (const auto& Entry : Entries)
+	{
+		if (Entry.Class)
+		{
+			SimulatedPhases.Add(Entry.GetGamePhaseTag(), { Entry.ParentPhaseTag, Entry.Class });
+			SimulatedClasses.Add(Entry.Class);
+		}
+	}
+
+	const auto* Graph{ OwnerComponent ? OwnerComponent->GetGamePhaseGraph() : nullptr };
+
+	for (const auto& Op : Ops)
+	{
+		if (Op.Type == EGamePhaseTransactionOpType::EndPhase)
+		{
+			// Only sub-phases can be ended
+
+			const auto* Phase{ SimulatedPhases.Find(Op.Tag) };
+
+			if (!Phase || !Phase->ParentPhaseTag.IsValid())
+			{
+				return false;
+			}
+
+			// Remove the subtree
+
+			TArray<FGameplayTag> RemovedTags{ Op.Tag };
+
+			for (auto Idx{ 0 }; Idx < RemovedTags.Num(); ++Idx)
+			{
+				for (const auto& KVP : SimulatedPhases)
+				{
+					if (KVP.Value.ParentPhaseTag == RemovedTags[Idx])
+					{
+						RemovedTags.Add(KVP.Key);
+					}
+				}
+			}
+
+			for (const auto& RemovedTag : RemovedTags)
+			{
+				SimulatedClasses.Remove(SimulatedPhases.FindChecked(RemovedTag).Class);
+				SimulatedPhases.Remove(RemovedTag);
+			}
+
+			continue;
+		}
+
+		if (Op.Type == EGamePhaseTransactionOpType::EndAllPhases)
+		{
+			// Fails if no game phase is active
+
+			if (SimulatedPhases.IsEmpty())
+			{
+				return false;
+			}
+
+			SimulatedPhases.Reset();
+			SimulatedClasses.Reset();
+			SimulatedCurrentPhaseTag = FGameplayTag::EmptyTag;
+
+			continue;
+		}
+
+		// Same checks as SetGamePhase and AddSubPhase
+
+		if (!Op.Class || SimulatedClasses.Contains(Op.Class))
+		{
+			return false;
+		}
+
+		const auto& GamePhaseTag{ Op.Class.GetDefaultObject()->GetGamePhaseTag() };
+
+		if (!GamePhaseTag.IsValid() || SimulatedPhases.Contains(GamePhaseTag))
+		{
+			return false;
+		}
+
+		if (Op.Type == EGamePhaseTransactionOpType::SetGamePhase)
+		{
+			if (Graph && !Graph->CanSetGamePhase(SimulatedCurrentPhaseTag, GamePhaseTag))
+			{
+				return false;
+			}
+
+			SimulatedPhases.Reset();
+			SimulatedClasses.Reset();
+			SimulatedCurrentPhaseTag = GamePhaseTag;
+		}
+		else if (!Op.Tag.IsValid() || !SimulatedPhases.Contains(Op.Tag))
+		{
+			return false;
+		}
+		else if (Graph && !Graph->CanAddSubPhase(Op.Tag, GamePhaseTag))
+		{
+			return false;
+		}
+
+		SimulatedPhases.Add(GamePhaseTag, { (Op.Type == EGamePhaseTransactionOpType::AddSubPhase) ? Op.Tag : FGameplayTag::EmptyTag, Op.Class });
+		SimulatedClasses.Add(Op.Class);
+	}
+
+	return true;
+}
+
+bool FActiveGamePhaseContainer::ApplyTransaction(const TArray<FGamePhaseTransactionOp>& Ops)
+{
+	check(Owner);
+	check(OwnerComponent);
+
+	if (!ValidateTransaction(Ops))
+	{
+		return false;
+	}
+
+	// Hold the listener events until all changes are applied, so that no listener sees the game phases partway through
+
+	FGamePhaseTransitionScope TransitionScope{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()), true };
+
+	BeginBatch();
+
+	for (const auto& Op : Ops)
+	{
+		switch (Op.Type)
+		{
+		case EGamePhaseTransactionOpType::SetGamePhase:
+			ensure(SetGamePhase(Op.Class, Op.Duration));
+			break;
+
+		case EGamePhaseTransactionOpType::AddSubPhase:
+			ensure(AddSubPhase(Op.Class, Op.Tag, Op.Duration));
+			break;
+
+		case EGamePhaseTransactionOpType::EndPhase:
+			ensure(EndPhaseByTag(Op.Tag));
+			break;
+
+		case EGamePhaseTransactionOpType::EndAllPhases:
+			ensure(EndAllGamePhases());
+			break;
+		}
+	}
+
+	EndBatch();
+
+	return true;
+}
+
+void FActiveGamePhaseContainer::BeginBatch()
+{
+	++BatchDepth;
+}
+
+void FActiveGamePhaseContainer::EndBatch()
+{
+	check(BatchDepth > 0);
+
+	if ((--BatchDepth == 0) && bBatchDirty)
+	{
+		bBatchDirty = false;
+
+		MarkEntriesDirty();
+	}
+}
+
+int32 FActiveGamePhaseContainer::FindEntryIndexByTag(const FGameplayTag& InGamePhaseTag) const
+{
+	if (bEntryIndexStale)
+	{
+		RebuildEntryIndex();
+	}
+
+	const auto* EntryIndex{ TagToEntryIndex.Find(InGamePhaseTag) };
+	return EntryIndex ? *EntryIndex : INDEX_NONE;
+}
+
+int32 FActiveGamePhaseContainer::FindEntryIndexByClass(const UClass* GamePhaseClass) const
+{
+	if (bEntryIndexStale)
+	{
+		RebuildEntryIndex();
+	}
+
+	const auto* EntryIndex{ ClassToEntryIndex.Find(GamePhaseClass) };
+	return EntryIndex ? *EntryIndex : INDEX_NONE;
+}
+
+int32 FActiveGamePhaseContainer::AddEntry(FActiveGamePhase&& NewEntry)
+{
+	if (bEntryIndexStale)
+	{
+		RebuildEntryIndex();
+	}
+
+	NewEntry.SequenceNumber = ++LastSequenceNumber;
+
+	// Sub-phases of a server-only game phase cannot be started on clients either, 
+	// and sub-phases of a game phase for relevant players only cannot be started on the other clients
+
+	const auto Policy{ NewEntry.Class.GetDefaultObject()->GetReplicationPolicy() };
+
+	NewEntry.bServerOnly = (Policy == EGamePhaseReplicationPolicy::ServerOnly);
+	NewEntry.bRelevantPlayersOnly = (Policy == EGamePhaseReplicationPolicy::RelevantPlayersOnly);
+
+	if (NewEntry.ParentPhaseTag.IsValid())
+	{
+		const auto ParentIndex{ FindEntryIndexByTag(NewEntry.ParentPhaseTag) };
+
+		if (ParentIndex != INDEX_NONE)
+		{
+			NewEntry.bServerOnly |= Entries[ParentIndex].bServerOnly;
+			NewEntry.bRelevantPlayersOnly |= Entries[ParentIndex].bRelevantPlayersOnly;
+		}
+	}
+
+	const auto EntryIndex{ Entries.Emplace(MoveTemp(NewEntry)) };
+	AddEntryToIndex(EntryIndex);
+
+	return EntryIndex;
+}
+
+void FActiveGamePhaseContainer::RemoveEntryAt(int32 EntryIndex)
+{
+	if (bEntryIndexStale)
+	{
+		RebuildEntryIndex();
+	}
+
+	const auto& Entry{ Entries[EntryIndex] };
+
+	if (Entry.Class)
+	{
+		if (const auto* TagIndex{ TagToEntryIndex.Find(Entry.GetGamePhaseTag()) }; TagIndex && (*TagIndex == EntryIndex))
+		{
+			TagToEntryIndex.Remove(Entry.GetGamePhaseTag());
+		}
+
+		ClassToEntryIndex.Remove(Entry.Class);
+
+		// Unlink from parent
+
+		if (Entry.ParentPhaseTag.IsValid())
+		{
+			if (auto* Siblings{ ChildPhaseTags.Find(Entry.ParentPhaseTag) })
+			{
+				Siblings->RemoveSingle(Entry.GetGamePhaseTag());
+
+				if (Siblings->IsEmpty())
+				{
+					ChildPhaseTags.Remove(Entry.ParentPhaseTag);
+				}
+			}
+		}
+	}
+
+	// Entry order has no meaning for replication, so the last entry is moved into the gap
+
+	const auto LastIndex{ Entries.Num() - 1 };
+
+	Entries.RemoveAtSwap(EntryIndex);
+
+	if (EntryIndex != LastIndex)
+	{
+		const auto& MovedEntry{ Entries[EntryIndex] };
+
+		if (MovedEntry.Class)
+		{
+			if (auto* TagIndex{ TagToEntryIndex.Find(MovedEntry.GetGamePhaseTag()) }; TagIndex && (*TagIndex == LastIndex))
+			{
+				*TagIndex = EntryIndex;
+			}
+
+			ClassToEntryIndex.Add(MovedEntry.Class, EntryIndex);
+		}
+	}
+}
+
+void FActiveGamePhaseContainer::AddEntryToIndex(int32 EntryIndex) const
+{
+	const auto& Entry{ Entries[EntryIndex] };
+
+	// Class may not be resolved yet on clients
+
+	if (Entry.Class)
+	{
+		TagToEntryIndex.Add(Entry.GetGamePhaseTag(), EntryIndex);
+		ClassToEntryIndex.Add(Entry.Class, EntryIndex);
+
+		// Link to parent
+
+		if (Entry.ParentPhaseTag.IsValid())
+		{
+			ChildPhaseTags.FindOrAdd(Entry.ParentPhaseTag).AddUnique(Entry.GetGamePhaseTag());
+		}
+	}
+}
+
+void FActiveGamePhaseContainer::RebuildEntryIndex() const
+{
+	TagToEntryIndex.Reset();
+	ClassToEntryIndex.Reset();
+	ChildPhaseTags.Reset();
+
+	for (auto Idx{ 0 }; Idx < Entries.Num(); ++Idx)
+	{
+		if (!PendingRemovedIndices.Contains(Idx))
+		{
+			AddEntryToIndex(Idx);
+		}
+	}
+
+	// Pending entries are still in Entries, so the indices are marked stale again once the serializer removes them
+
+	bEntryIndexStale = false;
+}
+
+void FActiveGamePhaseContainer::WriteNetIds(FActiveGamePhase& Entry)
+{
+	const auto* Registry{ UGamePhaseClassRegistry::Get() };
+
+	// Class
+
+	Entry.ClassNetId = Registry ? Registry->GetNetIdForClass(Entry.Class) : UGamePhaseClassRegistry::InvalidNetId;
+	Entry.FallbackClass = (Entry.ClassNetId == UGamePhaseClassRegistry::InvalidNetId) ? Entry.Class : nullptr;
+
+	// Parent
+
+	Entry.ParentClassNetId = UGamePhaseClassRegistry::InvalidNetId;
+	Entry.FallbackParentPhaseTag = FGameplayTag::EmptyTag;
+
+	if (Entry.ParentPhaseTag.IsValid())
+	{
+		const auto ParentIndex{ FindEntryIndexByTag(Entry.ParentPhaseTag) };
+
+		if (Registry && (ParentIndex != INDEX_NONE))
+		{
+			Entry.ParentClassNetId = Registry->GetNetIdForClass(Entries[ParentIndex].Class);
+		}
+
+		if (Entry.ParentClassNetId == UGamePhaseClassRegistry::InvalidNetId)
+		{
+			Entry.FallbackParentPhaseTag = Entry.ParentPhaseTag;
+		}
+	}
+}
+
+bool FActiveGamePhaseContainer::ReadNetIds(FActiveGamePhase& Entry, TArray<FSoftObjectPath>& OutClassPathsToLoad) const
+{
+	const auto* Registry{ UGamePhaseClassRegistry::Get() };
+
+	auto bResolved{ true };
+
+	// Classes are never loaded synchronously here, since this is called while receiving replicated data
+
+	const auto RequestLoad
+	{
+		[&](uint16 NetId)
+		{
+			const auto ClassPath{ Registry->GetClassPathForNetId(NetId) };
+
+			if (ClassPath.IsValid())
+			{
+				OutClassPathsToLoad.AddUnique(ClassPath);
+				bResolved = false;
+			}
+		}
+	};
+
+	// Class
+
+	Entry.Class = Entry.FallbackClass;
+
+	if (Registry && (Entry.ClassNetId != UGamePhaseClassRegistry::InvalidNetId))
+	{
+		Entry.Class = Registry->GetClassForNetId(Entry.ClassNetId);
+
+		if (!Entry.Class)
+		{
+			RequestLoad(Entry.ClassNetId);
+		}
+	}
+
+	// Parent
+
+	Entry.ParentPhaseTag = Entry.FallbackParentPhaseTag;
+
+	if (Registry && (Entry.ParentClassNetId != UGamePhaseClassRegistry::InvalidNetId))
+	{
+		if (const auto ParentClass{ Registry->GetClassForNetId(Entry.ParentClassNetId) })
+		{
+			Entry.ParentPhaseTag = ParentClass.GetDefaultObject()->GetGamePhaseTag();
+		}
+		else
+		{
+			RequestLoad(Entry.ParentClassNetId);
+		}
+	}
+
+	return bResolved;
+}
+
+void FActiveGamePhaseContainer::HandleGamePhaseAdd(FActiveGamePhase& ActiveGamePhase)
+{
+	INC_DWORD_STAT(STAT_GamePhase_NumActiveGamePhases);
+
+	// Copy what is needed, since the callbacks below may add or end game phases and reallocate Entries
+
+	const auto GamePhaseTag{ ActiveGamePhase.GetGamePhaseTag() };
+	const auto ParentPhaseTag{ ActiveGamePhase.ParentPhaseTag };
+
+	// Create new instance
+
+	auto* Instance{ OwnerComponent->AcquireGamePhaseInstance(ActiveGamePhase.Class) };
+	check(Instance);
+
+	ActiveGamePhase.Instance = Instance;
+
+	Instance->InitializeGamePhase(Owner.Get(), OwnerComponent.Get());
+	Instance->InitializeTiming(ActiveGamePhase.ServerStartTime, ActiveGamePhase.Duration, ActiveGamePhase.ServerPauseTime);
+
+	// Handle start
+	// 
+	// Note:
+	//	ActiveGamePhase must not be accessed from here on
+
+	Instance->HandleGamePhaseStart();
+
+	// Notify subsystem
+
+	if (auto* Subsystem{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) })
+	{
+		Subsystem->AddGamePhaseTag(GamePhaseTag);
+	}
+
+	// Notifies that a subphase has started if there is a parent game phase
+
+	if (ParentPhaseTag.IsValid())
+	{
+		HandleSubPhaseStart(ParentPhaseTag, GamePhaseTag);
+	}
+
+	// Load the game phases that can follow in the background
+
+	OwnerComponent->PrefetchSuccessorGamePhases(GamePhaseTag);
 }
 
 void FActiveGamePhaseContainer::HandleGamePhaseRemove(FActiveGamePhase& ActiveGamePhase)
 {
+	DEC_DWORD_STAT(STAT_GamePhase_NumActiveGamePhases);
+
+	// Copy what is needed, since the callbacks below may add or end game phases and reallocate Entries
+
+	const auto GamePhaseTag{ ActiveGamePhase.GetGamePhaseTag() };
+	const auto ParentPhaseTag{ ActiveGamePhase.ParentPhaseTag };
+	auto* Instance{ ActiveGamePhase.Instance.Get() };
+
 	// Handle End
+	// 
+	// Note:
+	//	ActiveGamePhase must not be accessed from here on
 
-	if (ActiveGamePhase.Instance)
+	if (Instance)
 	{
-		ActiveGamePhase.Instance->HandleGamePhaseEnd();
+		Instance->HandleGamePhaseEnd();
 	}
 
 	// Notify subsystem
 
-	const auto& GamePhaseTag{ ActiveGamePhase.GetGamePhaseTag() };
-
 	if (auto* Subsystem{ UWorld::GetSubsystem<UGamePhaseSubsystem>(Owner->GetWorld()) })
 	{
 		Subsystem->RemoveGamePhaseTag(GamePhaseTag);
@@ -254,38 +1464,57 @@ void FActiveGamePhaseContainer::HandleGamePhaseRemove(FActiveGamePhase& ActiveGa
 
 	// Notifies that a subphase has end if there is a parent game phase
 
-	if (ActiveGamePhase.ParentPhaseTag.IsValid())
+	if (ParentPhaseTag.IsValid())
 	{
-		HandleSubPhaseEnd(ActiveGamePhase.ParentPhaseTag, GamePhaseTag);
+		HandleSubPhaseEnd(ParentPhaseTag, GamePhaseTag);
 	}
+
+	// Detach the instance from the entry, looked up again since it may have moved
+
+	const auto EntryIndex{ FindEntryIndexByTag(GamePhaseTag) };
+
+	if ((EntryIndex != INDEX_NONE) && (Entries[EntryIndex].Instance == Instance))
+	{
+		Entries[EntryIndex].Instance = nullptr;
+	}
+
+	// Return instance to the pool
+
+	OwnerComponent->ReleaseGamePhaseInstance(Instance);
+
+	// Release the game phases prefetched for this game phase once no other game phase can follow them
+
+	OwnerComponent->ScheduleReleaseUnreachablePrefetches();
 }
 
 void FActiveGamePhaseContainer::HandleSubPhaseStart(const FGameplayTag& ParentPhaseTag, const FGameplayTag& SubPhaseTag)
 {
-	for (const auto& Entry : Entries)
+	const auto EntryIndex{ FindEntryIndexByTag(ParentPhaseTag) };
+
+	if (EntryIndex != INDEX_NONE)
 	{
-		if (Entry.GetGamePhaseTag() == ParentPhaseTag)
+		const auto& Entry{ Entries[EntryIndex] };
+
+		if (ensure(Entry.Instance))
 		{
-			if (ensure(Entry.Instance))
-			{
-				Entry.Instance->HandleSubPhaseStart(SubPhaseTag);
-				return;
-			}
+			Entry.Instance->HandleSubPhaseStart(SubPhaseTag);
 		}
 	}
 }
 
 void FActiveGamePhaseContainer::HandleSubPhaseEnd(const FGameplayTag& ParentPhaseTag, const FGameplayTag& SubPhaseTag)
 {
-	for (const auto& Entry : Entries)
+	const auto EntryIndex{ FindEntryIndexByTag(ParentPhaseTag) };
+
+	if (EntryIndex != INDEX_NONE)
 	{
-		if (Entry.GetGamePhaseTag() == ParentPhaseTag)
+		const auto& Entry{ Entries[EntryIndex] };
+
+		// Parent may have already ended when all game phases end together
+
+		if (Entry.Instance)
 		{
-			if (ensure(Entry.Instance))
-			{
-				Entry.Instance->HandleSubPhaseEnd(SubPhaseTag);
-				return;
-			}
+			Entry.Instance->HandleSubPhaseEnd(SubPhaseTag);
 		}
 	}
 }
@@ -9,6 +9,7 @@
 #include "ActiveGamePhase.generated.h"
 
 class AGameStateBase;
+class APlayerController;
 class UGamePhaseComponent;
 class UGamePhase;
 
@@ -22,33 +23,103 @@ struct GEPHASE_API FActiveGamePhase : public FFastArraySerializerItem
 	GENERATED_BODY()
 
 	friend struct FActiveGamePhaseContainer;
+	friend struct FGamePhaseTestAccess;
 
 public:
 	FActiveGamePhase() {}
 
-	FActiveGamePhase(const TSubclassOf<UGamePhase>& InClass) 
-		: Class(InClass) 
+	FActiveGamePhase(const TSubclassOf<UGamePhase>& InClass, float InDuration = 0.0f) 
+		: Duration(InDuration)
+		, Class(InClass) 
 	{}
 
-	FActiveGamePhase(const TSubclassOf<UGamePhase>& InClass, const FGameplayTag& InParentPhaseTag) 
-		: Class(InClass)
+	FActiveGamePhase(const TSubclassOf<UGamePhase>& InClass, const FGameplayTag& InParentPhaseTag, float InDuration = 0.0f) 
+		: Duration(InDuration)
+		, Class(InClass)
 		, ParentPhaseTag(InParentPhaseTag) 
 	{}
 
 protected:
 	//
-	// Class of game phase being applied
+	// Net ID of the game phase class in UGamePhaseClassRegistry
+	//
+	UPROPERTY()
+	uint16 ClassNetId{ 0 };
+
+	//
+	// Net ID of the parent game phase class in UGamePhaseClassRegistry
+	//
+	UPROPERTY()
+	uint16 ParentClassNetId{ 0 };
+
+	//
+	// Class of game phase replicated by reference
+	// 
+	// Tips:
+	//	Only set if the class has no net ID
+	//
+	UPROPERTY()
+	TSubclassOf<UGamePhase> FallbackClass{ nullptr };
+
+	//
+	// Parent phase of this game phase replicated by tag
+	// 
+	// Tips:
+	//	Only set if the parent class has no net ID
+	//
+	UPROPERTY()
+	FGameplayTag FallbackParentPhaseTag{ FGameplayTag::EmptyTag };
+
+	//
+	// Server world time when this game phase started
+	//
+	UPROPERTY()
+	double ServerStartTime{ 0.0 };
+
+	//
+	// Duration of this game phase in seconds
+	// 
+	// Tips:
+	//	0 or less means that this game phase has no duration
+	//
+	UPROPERTY()
+	float Duration{ 0.0f };
+
+	//
+	// Server world time when the timer of this game phase was paused
+	// 
+	// Tips:
+	//	0 means that the timer is running
+	//
+	UPROPERTY()
+	double ServerPauseTime{ 0.0 };
+
+	//
+	// Order in which the server added this game phase
+	// 
+	// Tips:
+	//	Used by clients to apply the replicated changes in server order
 	//
 	UPROPERTY()
+	uint32 SequenceNumber{ 0 };
+
+	//
+	// Class of game phase being applied
+	// 
+	// Tips:
+	//	Not replicated, but resolved from ClassNetId or FallbackClass on client
+	//
+	UPROPERTY(NotReplicated)
 	TSubclassOf<UGamePhase> Class{ nullptr };
 
 	//
 	// Parent phase of this game phase
 	// 
 	// Tips:
-	//	Set if this game phase was a subphase initiated by the parent phase
+	//	Set if this game phase was a subphase initiated by the parent phase.
+	//	Not replicated, but resolved from ParentClassNetId or FallbackParentPhaseTag on client
 	//
-	UPROPERTY()
+	UPROPERTY(NotReplicated)
 	FGameplayTag ParentPhaseTag{ FGameplayTag::EmptyTag };
 
 	//
@@ -60,15 +131,46 @@ protected:
 	UPROPERTY(NotReplicated)
 	TObjectPtr<UGamePhase> Instance{ nullptr };
 
-protected:
+	//
+	// Game phase tag of the class
+	// 
+	// Tips:
+	//	Not replicated, but resolved from the class once on both server and client
+	//
+	UPROPERTY(NotReplicated)
+	FGameplayTag GamePhaseTag{ FGameplayTag::EmptyTag };
 
+	//
+	// Whether this game phase is kept from clients
+	// 
+	// Tips:
+	//	Decided on the server from the replication policy of the class and the parent game phase
+	//
+	UPROPERTY(NotReplicated)
+	bool bServerOnly{ false };
 
+	//
+	// Whether this game phase is only sent to the players that it or one of its parent phases is relevant to
+	// 
+	// Tips:
+	//	Decided on the server from the replication policy of the class and the parent game phase
+	//
+	UPROPERTY(NotReplicated)
+	bool bRelevantPlayersOnly{ false };
 
 protected:
+	/**
+	 * Resolve and store the game phase tag of the class
+	 * 
+	 * Tips:
+	 *	Returns false if the class does not have a valid game phase tag
+	 */
+	bool CacheGamePhaseTag();
+
 	/**
 	 * Return game phase tag
 	 */
-	const FGameplayTag& GetGamePhaseTag() const;
+	const FGameplayTag& GetGamePhaseTag() const { return GamePhaseTag; }
 
 public:
 	/**
@@ -79,6 +181,83 @@ public:
 };
 
 
+/**
+ * Data of a sub-phase started locally on a client ahead of replication
+ */
+USTRUCT()
+struct GEPHASE_API FPredictedGamePhase
+{
+	GENERATED_BODY()
+public:
+	FPredictedGamePhase() {}
+
+public:
+	UPROPERTY()
+	TSubclassOf<UGamePhase> Class{ nullptr };
+
+	UPROPERTY()
+	FGameplayTag GamePhaseTag{ FGameplayTag::EmptyTag };
+
+	UPROPERTY()
+	FGameplayTag ParentPhaseTag{ FGameplayTag::EmptyTag };
+
+	UPROPERTY()
+	TObjectPtr<UGamePhase> Instance{ nullptr };
+
+	//
+	// Local world time when this game phase was predicted
+	//
+	double PredictionTime{ 0.0 };
+
+};
+
+
+/**
+ * Type of a game phase change recorded in a transaction
+ */
+UENUM()
+enum class EGamePhaseTransactionOpType : uint8
+{
+	SetGamePhase,
+	AddSubPhase,
+	EndPhase,
+	EndAllPhases
+};
+
+
+/**
+ * Single game phase change recorded in a transaction
+ */
+USTRUCT()
+struct GEPHASE_API FGamePhaseTransactionOp
+{
+	GENERATED_BODY()
+public:
+	FGamePhaseTransactionOp() {}
+
+	FGamePhaseTransactionOp(EGamePhaseTransactionOpType InType, const TSubclassOf<UGamePhase>& InClass, const FGameplayTag& InTag, float InDuration)
+		: Type(InType), Class(InClass), Tag(InTag), Duration(InDuration)
+	{}
+
+public:
+	UPROPERTY()
+	EGamePhaseTransactionOpType Type{ EGamePhaseTransactionOpType::SetGamePhase };
+
+	UPROPERTY()
+	TSubclassOf<UGamePhase> Class{ nullptr };
+
+	//
+	// Parent phase tag for AddSubPhase or the tag of the game phase to end for EndPhase
+	//
+	UPROPERTY()
+	FGameplayTag Tag{ FGameplayTag::EmptyTag };
+
+	UPROPERTY()
+	float Duration{ 0.0f };
+
+};
+
+
 /**
  * List of ActiveGamePhase
  */
@@ -86,6 +265,9 @@ USTRUCT(BlueprintType)
 struct GEPHASE_API FActiveGamePhaseContainer : public FFastArraySerializer
 {
 	GENERATED_BODY()
+
+	friend struct FGamePhaseTestAccess;
+
 public:
 	FActiveGamePhaseContainer() {}
 
@@ -110,28 +292,272 @@ public:
 	UPROPERTY(NotReplicated)
 	TObjectPtr<UGamePhaseComponent> OwnerComponent{ nullptr };
 
+protected:
+	//
+	// Index of the entry in Entries for each game phase tag
+	//
+	mutable TMap<FGameplayTag, int32> TagToEntryIndex;
+
+	//
+	// Index of the entry in Entries for each game phase class
+	//
+	mutable TMap<const UClass*, int32> ClassToEntryIndex;
+
+	//
+	// Tags of the sub-phases for each parent game phase tag, in the order they started
+	// 
+	// Tips:
+	//	Stored inline so that starting and ending sub-phases does not allocate
+	//
+	mutable TMap<FGameplayTag, TArray<FGameplayTag, TInlineAllocator<4>>> ChildPhaseTags;
+
+	//
+	// Whether the entry indices no longer match Entries
+	// 
+	// Tips:
+	//	Set on clients when replication removes entries, since the removal itself is performed by the serializer
+	//
+	mutable bool bEntryIndexStale{ false };
+
+	//
+	// Indices of the entries removed by replication and not yet removed from Entries by the serializer
+	// 
+	// Tips:
+	//	They are skipped when the entry indices are rebuilt in the middle of an update, 
+	//	and the indices are marked stale again when the update is received so that they are rebuilt once the entries are gone.
+	//
+	TArray<int32> PendingRemovedIndices;
+
+	//
+	// Sub-phases started locally on a client and not yet confirmed by the server
+	//
+	UPROPERTY(NotReplicated)
+	TArray<FPredictedGamePhase> PredictedPhases;
+
+	//
+	// Depth of the batches in progress and whether the entries were changed in them
+	// 
+	// Tips:
+	//	The array is marked dirty only once when the outermost batch ends
+	//
+	int32 BatchDepth{ 0 };
+	bool bBatchDirty{ false };
+
+	//
+	// Whether a replicated update is being received as a single transition on clients
+	//
+	bool bReceivingReplicatedBatch{ false };
+
+	//
+	// Last sequence number given to an added entry on the server
+	//
+	uint32 LastSequenceNumber{ 0 };
+
+	//
+	// Player of the connection that the entries are being written to on the server
+	// 
+	// Tips:
+	//	Only set during NetDeltaSerialize
+	//
+	const APlayerController* ReplicatingPlayer{ nullptr };
+
+	//
+	// Replication IDs of the replicated sub-phases waiting for their parent to be added on clients
+	//
+	TArray<int32> DeferredReplicationIDs;
+
+	//
+	// Replication IDs of the replicated entries waiting for their class or parent class to be loaded on clients
+	//
+	TArray<int32> LoadingReplicationIDs;
+
 public:
 	void PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize);
 	void PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize);
 	void PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize);
+	void PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters);
 
 	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
 	{
+		// Remember the player being written to, so that the entries can be filtered per connection
+
+		TGuardValue<const APlayerController*> ReplicatingPlayerGuard(ReplicatingPlayer, GetReplicatingPlayer(DeltaParms));
+
 		return FFastArraySerializer::FastArrayDeltaSerialize<FActiveGamePhase, FActiveGamePhaseContainer>(Entries, DeltaParms, *this);
 	}
 
+	template<typename Type, typename SerializerType>
+	bool ShouldWriteFastArrayItem(const Type& Item, const bool bIsWritingOnClient)
+	{
+		// Server-only game phases are never sent to clients
+
+		if (bIsWritingOnClient)
+		{
+			return Item.ReplicationID != INDEX_NONE;
+		}
+
+		if (Item.bServerOnly)
+		{
+			return false;
+		}
+
+		return !Item.bRelevantPlayersOnly || IsEntryRelevantToPlayer(Item, ReplicatingPlayer);
+	}
+
+	/**
+	 * Mark the array dirty so that the relevancy of the RelevantPlayersOnly game phases is checked again for every connection
+	 * 
+	 * Tips:
+	 *	Connections that an entry is no longer relevant to see it removed, and the others see it added
+	 */
+	void RefreshRelevancy();
+
+protected:
+	/**
+	 * Returns the player of the connection that the delta serialization writes to, or null if not writing on the server
+	 */
+	static const APlayerController* GetReplicatingPlayer(const FNetDeltaSerializeInfo& DeltaParms);
+
+	/**
+	 * Returns whether the entry and all its RelevantPlayersOnly parent phases are relevant to the player
+	 */
+	bool IsEntryRelevantToPlayer(const FActiveGamePhase& Entry, const APlayerController* PlayerController) const;
+
+public:
+
+	/**
+	 * Start the replicated entries whose classes have finished loading on clients
+	 */
+	void HandleReplicatedClassesLoaded();
+
 public:
-	bool SetGamePhase(const TSubclassOf<UGamePhase>& GamePhaseClass);
+	bool SetGamePhase(const TSubclassOf<UGamePhase>& GamePhaseClass, float Duration = 0.0f);
 
-	bool AddSubPhase(const TSubclassOf<UGamePhase>& GamePhaseClass, const FGameplayTag& InParentPhaseTag);
+	bool AddSubPhase(const TSubclassOf<UGamePhase>& GamePhaseClass, const FGameplayTag& InParentPhaseTag, float Duration = 0.0f);
 
 	bool EndPhaseByTag(const FGameplayTag& InGamePhaseTag);
 
+	/**
+	 * End all game phases as a single transition
+	 * 
+	 * Tips:
+	 *	Returns false if no game phase is active
+	 */
+	bool EndAllGamePhases();
+
 	TSubclassOf<UGamePhase> GetCurrentGamePhaseClass() const;
 
+	/**
+	 * Returns the tag of the game phase that is not a sub-phase, or an empty tag if no game phase is active
+	 */
+	FGameplayTag GetCurrentGamePhaseTag() const;
+
+	/**
+	 * Returns the tags of all active game phases, including sub-phases
+	 */
+	void GetActiveGamePhaseTags(TArray<FGameplayTag>& OutGamePhaseTags) const;
+
+	UGamePhase* FindGamePhaseByTag(const FGameplayTag& InGamePhaseTag) const;
+
+	/**
+	 * Returns the tag of the parent phase of the game phase, or an empty tag if it is not a sub-phase
+	 */
+	FGameplayTag GetParentPhaseTag(const FGameplayTag& InGamePhaseTag) const;
+
+	/**
+	 * Pause or resume the timer of the game phase
+	 * 
+	 * Tips:
+	 *	Returns false if the game phase has no duration or the timer is already in that state
+	 */
+	bool SetGamePhaseTimerPaused(const FGameplayTag& InGamePhaseTag, bool bPaused);
+
+public:
+	bool PredictSubPhase(const TSubclassOf<UGamePhase>& GamePhaseClass, const FGameplayTag& InParentPhaseTag, float Duration = 0.0f);
+
+	bool IsGamePhasePredicted(const FGameplayTag& InGamePhaseTag) const;
+
+	/**
+	 * Roll back the predictions made before the specified local world time
+	 * 
+	 * Tips:
+	 *	Returns the time of the oldest remaining prediction, or a negative value if there are none
+	 */
+	double RollbackExpiredPredictions(double ExpireBeforeTime);
+
+	void RollbackAllPredictions();
+
+public:
+	/**
+	 * Returns whether the changes can be applied in order to the current game phases
+	 */
+	bool ValidateTransaction(const TArray<FGamePhaseTransactionOp>& Ops) const;
+
+	/**
+	 * Apply the changes as a single transition and a single replication update
+	 * 
+	 * Tips:
+	 *	Nothing is applied if any of the changes is invalid.
+	 *	Listeners are notified only after all changes are applied, although the game phases themselves start and end in order.
+	 */
+	bool ApplyTransaction(const TArray<FGamePhaseTransactionOp>& Ops);
+
+protected:
+	void BeginBatch();
+	void EndBatch();
+
+	void BeginReplicatedBatch();
+
 protected:
 	void EndAllPhase();
 
+	int32 FindEntryIndexByTag(const FGameplayTag& InGamePhaseTag) const;
+	int32 FindEntryIndexByClass(const UClass* GamePhaseClass) const;
+
+	int32 AddEntry(FActiveGamePhase&& NewEntry);
+	void RemoveEntryAt(int32 EntryIndex);
+
+	void AddEntryToIndex(int32 EntryIndex) const;
+	void RebuildEntryIndex() const;
+
+	//
+	// Tags of a subtree of game phases, kept inline since transitions rarely end more than a few at once
+	//
+	using FGamePhaseTagArray = TArray<FGameplayTag, TInlineAllocator<8>>;
+
+	/**
+	 * Collect the tags of the game phase and all of its sub-phases, deepest and most recently started first
+	 */
+	void CollectSubtreeDeepestFirst(const FGameplayTag& InGamePhaseTag, FGamePhaseTagArray& OutGamePhaseTags) const;
+
+	/**
+	 * End and remove the game phases in order without marking the array dirty
+	 */
+	void RemovePhases(const FGamePhaseTagArray& GamePhaseTags);
+
+	void MarkEntryDirty(FActiveGamePhase& Entry);
+	void MarkEntriesDirty();
+
+	void WriteNetIds(FActiveGamePhase& Entry);
+
+	/**
+	 * Resolve the class and parent tag of the replicated entry
+	 * 
+	 * Tips:
+	 *	Returns false and adds the paths to OutClassPathsToLoad if the class or the parent class is not loaded yet
+	 */
+	bool ReadNetIds(FActiveGamePhase& Entry, TArray<FSoftObjectPath>& OutClassPathsToLoad) const;
+
+	/**
+	 * Start the replicated entries in server order together with the entries deferred in previous updates
+	 */
+	void HandleReplicatedEntriesAdded(const TArrayView<const int32> AddedIndices);
+
+	int32 FindPredictionIndexByTag(const FGameplayTag& InGamePhaseTag) const;
+	bool ConfirmPrediction(FActiveGamePhase& ActiveGamePhase);
+	void RollbackPredictionAt(int32 PredictionIndex);
+	void RollbackPredictionsOfParent(const FGameplayTag& InParentPhaseTag);
+
 	void HandleGamePhaseAdd(FActiveGamePhase& ActiveGamePhase);
 	void HandleGamePhaseRemove(FActiveGamePhase& ActiveGamePhase);
 
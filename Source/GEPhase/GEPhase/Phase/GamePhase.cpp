@@ -6,6 +6,8 @@
 #include "GEPhaseLogs.h"
 
 #include "GameFramework/GameStateBase.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
 #include "GameplayTask.h"
 
 #if WITH_EDITOR
@@ -32,6 +34,20 @@ EDataValidationResult UGamePhase::IsDataValid(FDataValidationContext& Context) c
 		Context.AddError(FText::FromString(FString::Printf(TEXT("GamePhaseTag must be set to a tag representing the current phase."))));
 	}
 
+	if ((OnExpired == EGamePhaseExpiredAction::NextGamePhase) && !NextGamePhaseClass)
+	{
+		Result = EDataValidationResult::Invalid;
+
+		Context.AddError(FText::FromString(FString::Printf(TEXT("NextGamePhaseClass must be set when OnExpired is NextGamePhase."))));
+	}
+	else if ((OnExpired == EGamePhaseExpiredAction::NextGamePhase) 
+		&& ((NextGamePhaseClass == GetClass()) || (NextGamePhaseClass.GetDefaultObject()->GetGamePhaseTag() == GamePhaseTag)))
+	{
+		Result = EDataValidationResult::Invalid;
+
+		Context.AddError(FText::FromString(FString::Printf(TEXT("NextGamePhaseClass must not be this class or share its GamePhaseTag, since a game phase cannot replace itself."))));
+	}
+
 	return Result;
 }
 #endif
@@ -44,6 +60,71 @@ void UGamePhase::InitializeGamePhase(AGameStateBase* GameState, UGamePhaseCompon
 }
 
 
+void UGamePhase::ResetGamePhase()
+{
+	// Timers and latent actions started by the game phase must not fire on the pooled instance
+
+	if (auto* World{ GetWorld() })
+	{
+		World->GetTimerManager().ClearAllTimersForObject(this);
+		World->GetLatentActionManager().RemoveActionsForObject(this);
+	}
+
+	ActiveTasks.Reset();
+	NumSpawnedTasks = 0;
+
+	ServerStartTime = 0.0;
+	Duration = 0.0f;
+	ServerPauseTime = 0.0;
+
+	OnResetGamePhase();
+}
+
+
+void UGamePhase::InitializeTiming(double InServerStartTime, float InDuration, double InServerPauseTime)
+{
+	ServerStartTime = InServerStartTime;
+	Duration = InDuration;
+	ServerPauseTime = InServerPauseTime;
+}
+
+float UGamePhase::GetElapsedTime() const
+{
+	if (!Owner.IsValid())
+	{
+		return 0.0f;
+	}
+
+	const auto ServerTime{ IsTimerPaused() ? ServerPauseTime : Owner->GetServerWorldTimeSeconds() };
+
+	return static_cast<float>(FMath::Max(ServerTime - ServerStartTime, 0.0));
+}
+
+float UGamePhase::GetRemainingTime() const
+{
+	if (!HasDuration())
+	{
+		return -1.0f;
+	}
+
+	return FMath::Max(Duration - GetElapsedTime(), 0.0f);
+}
+
+bool UGamePhase::PauseTimer()
+{
+	check(OwnerComponent.IsValid());
+
+	return OwnerComponent->PauseGamePhaseTimer(GetGamePhaseTag());
+}
+
+bool UGamePhase::ResumeTimer()
+{
+	check(OwnerComponent.IsValid());
+
+	return OwnerComponent->ResumeGamePhaseTimer(GetGamePhaseTag());
+}
+
+
 UGameplayTasksComponent* UGamePhase::GetGameplayTasksComponent(const UGameplayTask& Task) const
 {
 	return OwnerComponent.Get();
@@ -64,6 +145,7 @@ void UGamePhase::OnGameplayTaskActivated(UGameplayTask& Task)
 	UE_LOG(LogGameExt_GamePhaseTask, Log, TEXT("Game phase task started: %s"), *Task.GetName());
 
 	ActiveTasks.Add(&Task);
+	++NumSpawnedTasks;
 }
 
 void UGamePhase::OnGameplayTaskDeactivated(UGameplayTask& Task)
@@ -73,19 +155,39 @@ void UGamePhase::OnGameplayTaskDeactivated(UGameplayTask& Task)
 	ActiveTasks.Remove(&Task);
 }
 
+void UGamePhase::EndAllTasks()
+{
+	// Take the tasks out first so that ending them does not modify the set being iterated, 
+	// and repeat for the tasks started by the ending ones
+
+	while (!ActiveTasks.IsEmpty())
+	{
+		auto TasksToEnd{ MoveTemp(ActiveTasks) };
+		ActiveTasks.Reset();
 
-bool UGamePhase::NextGamePhase(TSubclassOf<UGamePhase> GamePhaseClass)
+		for (const auto& Task : TasksToEnd)
+		{
+			if (Task)
+			{
+				Task->TaskOwnerEnded();
+			}
+		}
+	}
+}
+
+
+bool UGamePhase::NextGamePhase(TSubclassOf<UGamePhase> GamePhaseClass, float NewDuration)
 {
 	check(OwnerComponent.IsValid());
 
-	return OwnerComponent->SetGamePhase(GamePhaseClass);
+	return OwnerComponent->SetGamePhase(GamePhaseClass, NewDuration);
 }
 
-bool UGamePhase::StartSubPhase(TSubclassOf<UGamePhase> GamePhaseClass)
+bool UGamePhase::StartSubPhase(TSubclassOf<UGamePhase> GamePhaseClass, float NewDuration)
 {
 	check(OwnerComponent.IsValid());
 
-	return OwnerComponent->AddSubPhase(GamePhaseClass, GetGamePhaseTag());
+	return OwnerComponent->AddSubPhase(GamePhaseClass, GetGamePhaseTag(), NewDuration);
 }
 
 bool UGamePhase::EndPhase()
@@ -102,6 +204,16 @@ void UGamePhase::HandleGamePhaseStart()
 		, HasAuthority() ? TEXT("SERVER") : TEXT("CLIENT")
 		, *GetNameSafe(this));
 
+	if (bEnableTick && OwnerComponent.IsValid())
+	{
+		OwnerComponent->AddTickingGamePhase(this);
+	}
+
+	if (HasAuthority() && HasDuration() && !IsTimerPaused() && OwnerComponent.IsValid())
+	{
+		OwnerComponent->ScheduleGamePhaseExpiry(this);
+	}
+
 	OnGamePhaseStart();
 }
 
@@ -111,19 +223,86 @@ void UGamePhase::HandleGamePhaseEnd()
 		, HasAuthority() ? TEXT("SERVER") : TEXT("CLIENT")
 		, *GetNameSafe(this));
 
+	if (bEnableTick && OwnerComponent.IsValid())
+	{
+		OwnerComponent->RemoveTickingGamePhase(this);
+	}
+
+	if (HasAuthority() && HasDuration() && OwnerComponent.IsValid())
+	{
+		OwnerComponent->CancelGamePhaseExpiry(GamePhaseTag);
+	}
+
 	// End tasks
 
-	for (auto TaskIdx{ ActiveTasks.Num() - 1 }; (TaskIdx >= 0) && (ActiveTasks.Num() > 0); --TaskIdx)
+	EndAllTasks();
+
+	OnGamePhaseEnd();
+}
+
+void UGamePhase::HandleGamePhaseExpired()
+{
+	UE_LOG(LogGameExt_GamePhase, Log, TEXT("[%s] Game phase expired: %s")
+		, HasAuthority() ? TEXT("SERVER") : TEXT("CLIENT")
+		, *GetNameSafe(this));
+
+	check(OwnerComponent.IsValid());
+
+	auto* Component{ OwnerComponent.Get() };
+	const auto ThisGamePhaseTag{ GamePhaseTag };
+
+	OnGamePhaseExpired();
+
+	// Suspend if this game phase was ended by the event
+
+	if (Component->FindGamePhaseByTag(ThisGamePhaseTag) != this)
+	{
+		return;
+	}
+
+	const auto ParentPhaseTag{ Component->GetParentPhaseTag(ThisGamePhaseTag) };
+
+	if (OnExpired == EGamePhaseExpiredAction::EndPhase)
 	{
-		if (auto Task{ ActiveTasks[TaskIdx] })
+		// EndPhaseByTag only ends sub-phases, so the current game phase ends everything
+
+		if (!ParentPhaseTag.IsValid())
+		{
+			Component->EndAllGamePhases();
+		}
+		else
 		{
-			Task->TaskOwnerEnded();
+			Component->EndPhaseByTag(ThisGamePhaseTag);
 		}
 	}
+	else if ((OnExpired == EGamePhaseExpiredAction::NextGamePhase) && NextGamePhaseClass)
+	{
+		auto bSucceeded{ false };
 
-	ActiveTasks.Reset();
+		if (!ParentPhaseTag.IsValid())
+		{
+			bSucceeded = Component->SetGamePhase(NextGamePhaseClass);
+		}
+		else
+		{
+			// Replace this sub-phase as a single transition, which only checks the changes when committed
 
-	OnGamePhaseEnd();
+			FGamePhaseTransaction Transaction{ Component };
+
+			bSucceeded = Component->EndPhaseByTag(ThisGamePhaseTag) && Component->AddSubPhase(NextGamePhaseClass, ParentPhaseTag) && Transaction.Commit();
+		}
+
+		if (!bSucceeded)
+		{
+			UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Failed to move expired game phase to next game phase: %s -> %s")
+				, *GetNameSafe(GetClass()), *GetNameSafe(NextGamePhaseClass));
+		}
+	}
+}
+
+void UGamePhase::TickGamePhase(float DeltaTime)
+{
+	OnTickGamePhase(DeltaTime);
 }
 
 void UGamePhase::HandleSubPhaseStart(const FGameplayTag& SubPhaseTag)
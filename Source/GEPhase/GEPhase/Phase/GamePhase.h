@@ -9,9 +9,44 @@
 #include "GamePhase.generated.h"
 
 class AGameStateBase;
+class APlayerController;
 class UGamePhaseComponent;
 
 
+/**
+ * Which machines a game phase exists on
+ */
+UENUM(BlueprintType)
+enum class EGamePhaseReplicationPolicy : uint8
+{
+	// Replicated to and instantiated on all clients
+	ReplicateToAll,
+
+	// Exists only on the server and is never sent to clients
+	ServerOnly,
+
+	// Replicated only to the players that the game phase is relevant to, see IsRelevantToPlayer
+	RelevantPlayersOnly
+};
+
+
+/**
+ * What happens when the duration of a game phase runs out
+ */
+UENUM(BlueprintType)
+enum class EGamePhaseExpiredAction : uint8
+{
+	// Only OnGamePhaseExpired is called
+	None,
+
+	// The game phase is ended, or all game phases if it is not a sub-phase
+	EndPhase,
+
+	// The game phase is replaced by NextGamePhaseClass
+	NextGamePhase
+};
+
+
 /**
  * Class representing the current game phase
  *
@@ -50,11 +85,262 @@ public:
 	void InitializeGamePhase(AGameStateBase* GameState, UGamePhaseComponent* GamePhaseComponent);
 
 
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Pooling
+protected:
+	//
+	// Whether instances of this game phase are reused after ending instead of being reallocated
+	// 
+	// Note:
+	//	State set during the game phase must be cleared in OnResetGamePhase
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Pooling")
+	bool bPoolInstances{ false };
+
+public:
+	bool ShouldPoolInstances() const { return bPoolInstances; }
+
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Replication
+protected:
+	//
+	// Which machines this game phase exists on
+	// 
+	// Tips:
+	//	Use ServerOnly for bookkeeping phases with no client-facing behaviour, such as bots or matchmaking logic.
+	//	Use RelevantPlayersOnly for phases that only concern some players, such as the turn of a player or a team.
+	//	Sub-phases of a server-only game phase are also server-only, 
+	//	and sub-phases of a RelevantPlayersOnly game phase are only sent to the players it is relevant to.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Replication")
+	EGamePhaseReplicationPolicy ReplicationPolicy{ EGamePhaseReplicationPolicy::ReplicateToAll };
+
+public:
+	EGamePhaseReplicationPolicy GetReplicationPolicy() const { return ReplicationPolicy; }
+
+	/**
+	 * Returns whether this game phase is sent to the connection of the player
+	 * 
+	 * Tips:
+	 *	Only called on the server for RelevantPlayersOnly game phases, each time the active game phases are written to a connection.
+	 *	Call UGamePhaseComponent::RefreshGamePhaseRelevancy when the result changes.
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = "Replication")
+	bool IsRelevantToPlayer(const APlayerController* PlayerController) const;
+	virtual bool IsRelevantToPlayer_Implementation(const APlayerController* PlayerController) const { return false; }
+
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Preload
+protected:
+	//
+	// Assets loaded in the background together with this game phase class when it is prefetched
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Preload")
+	TArray<TSoftObjectPtr<UObject>> PreloadAssets;
+
+public:
+	const TArray<TSoftObjectPtr<UObject>>& GetPreloadAssets() const { return PreloadAssets; }
+
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Tick
+protected:
+	//
+	// Whether this game phase receives OnTickGamePhase while it is active
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Tick")
+	bool bEnableTick{ false };
+
+	//
+	// Seconds between ticks of this game phase
+	// 
+	// Tips:
+	//	0 means every frame. Game phases with the same interval are ticked together.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Tick", meta = (ClampMin = 0.0, Units = "s", EditCondition = "bEnableTick"))
+	float TickInterval{ 0.0f };
+
+public:
+	bool IsTickEnabled() const { return bEnableTick; }
+	float GetTickInterval() const { return TickInterval; }
+
+	/**
+	 * Called at the tick interval while this game phase is active if the tick is enabled
+	 */
+	void TickGamePhase(float DeltaTime);
+
+	/**
+	 * Clear the state of this game phase so that it can be reused
+	 * 
+	 * Tips:
+	 *	Timers and latent actions of this game phase are cancelled
+	 */
+	virtual void ResetGamePhase();
+
+protected:
+	UFUNCTION(BlueprintNativeEvent, Category = "GamePhase")
+	void OnResetGamePhase();
+	virtual void OnResetGamePhase_Implementation() {}
+
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Timing
+protected:
+	//
+	// Duration used when this game phase is started without one
+	// 
+	// Tips:
+	//	0 means that this game phase has no duration
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Timing", meta = (ClampMin = 0.0, Units = "s"))
+	float DefaultDuration{ 0.0f };
+
+	//
+	// What happens when the duration of this game phase runs out
+	// 
+	// Tips:
+	//	Only performed on the server. OnGamePhaseExpired is called before it in any case.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Timing")
+	EGamePhaseExpiredAction OnExpired{ EGamePhaseExpiredAction::None };
+
+	//
+	// Game phase that replaces this game phase when its duration runs out
+	// 
+	// Tips:
+	//	If this game phase is a sub-phase, the next game phase is started as a sub-phase of the same parent.
+	//	Must not be this class or share its GamePhaseTag, since a game phase cannot replace itself.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Timing", meta = (EditCondition = "OnExpired == EGamePhaseExpiredAction::NextGamePhase"))
+	TSubclassOf<UGamePhase> NextGamePhaseClass{ nullptr };
+
+	//
+	// Server world time when this game phase started
+	//
+	UPROPERTY(Transient)
+	double ServerStartTime{ 0.0 };
+
+	//
+	// Duration of this game phase in seconds
+	// 
+	// Tips:
+	//	0 or less means that this game phase has no duration
+	//
+	UPROPERTY(Transient)
+	float Duration{ 0.0f };
+
+	//
+	// Server world time when the timer of this game phase was paused, or 0 if it is running
+	//
+	UPROPERTY(Transient)
+	double ServerPauseTime{ 0.0 };
+
+public:
+	float GetDefaultDuration() const { return DefaultDuration; }
+	EGamePhaseExpiredAction GetExpiredAction() const { return OnExpired; }
+	TSubclassOf<UGamePhase> GetNextGamePhaseClass() const { return NextGamePhaseClass; }
+
+	void InitializeTiming(double InServerStartTime, float InDuration, double InServerPauseTime = 0.0);
+
+	/**
+	 * Returns whether the timer of this game phase is paused
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Timing")
+	bool IsTimerPaused() const { return ServerPauseTime > 0.0; }
+
+	/**
+	 * Returns the server world time when this game phase started
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Timing")
+	double GetServerStartTime() const { return ServerStartTime; }
+
+	/**
+	 * Returns whether this game phase has a duration
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Timing")
+	bool HasDuration() const { return Duration > 0.0f; }
+
+	/**
+	 * Returns the duration of this game phase in seconds
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Timing")
+	float GetDuration() const { return Duration; }
+
+	/**
+	 * Returns the seconds elapsed since this game phase started
+	 * 
+	 * Tips:
+	 *	Computed from the synchronized server world time, so it can be used for countdowns on clients without ticking
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Timing")
+	float GetElapsedTime() const;
+
+	/**
+	 * Returns the seconds remaining until the duration of this game phase runs out
+	 * 
+	 * Tips:
+	 *	Returns -1 if this game phase has no duration
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Timing")
+	float GetRemainingTime() const;
+
+protected:
+	/**
+	 * Stop the timer of this game phase from running out
+	 * 
+	 * Note:
+	 *	Authority is required
+	 * 
+	 * Tips:
+	 *	The elapsed and remaining time stay the same until the timer is resumed
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Timing")
+	bool PauseTimer();
+
+	/**
+	 * Resume the paused timer of this game phase
+	 * 
+	 * Note:
+	 *	Authority is required
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase|Timing")
+	bool ResumeTimer();
+
+
 	/////////////////////////////////////////////////////////////////////////////////////
 	// IGameplayTaskOwnerInterface
 protected:
+	//
+	// Tasks owned by this game phase that are currently active
+	//
 	UPROPERTY(Transient)
-	TArray<TObjectPtr<UGameplayTask>> ActiveTasks;
+	TSet<TObjectPtr<UGameplayTask>> ActiveTasks;
+
+	//
+	// Number of tasks activated by this game phase since it started
+	//
+	int32 NumSpawnedTasks{ 0 };
+
+public:
+	/**
+	 * Returns the number of tasks of this game phase that are currently active
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Task")
+	int32 GetNumLiveTasks() const { return ActiveTasks.Num(); }
+
+	/**
+	 * Returns the number of tasks activated by this game phase since it started
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "GamePhase|Task")
+	int32 GetNumSpawnedTasks() const { return NumSpawnedTasks; }
+
+protected:
+	/**
+	 * End all active tasks, including the tasks started while ending the others
+	 */
+	void EndAllTasks();
 
 public:
 	virtual UGameplayTasksComponent* GetGameplayTasksComponent(const UGameplayTask& Task) const override;
@@ -99,7 +385,7 @@ protected:
 	 *	Also, if this was a sub-phase of another game phase, its parent game phase is also terminated.
 	 */
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
-	bool NextGamePhase(TSubclassOf<UGamePhase> GamePhaseClass);
+	bool NextGamePhase(TSubclassOf<UGamePhase> GamePhaseClass, float NewDuration = 0.0f);
 
 	/**
 	 * Start sub-phase.
@@ -114,7 +400,7 @@ protected:
 	 *	but this is not recommended because it is difficult to manage.
 	 */
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "GamePhase")
-	bool StartSubPhase(TSubclassOf<UGamePhase> GamePhaseClass);
+	bool StartSubPhase(TSubclassOf<UGamePhase> GamePhaseClass, float NewDuration = 0.0f);
 
 	/**
 	 * End this game phase
@@ -154,6 +440,11 @@ public:
 	 */
 	void HandleSubPhaseEnd(const FGameplayTag& SubPhaseTag);
 
+	/**
+	 * Called on the server when the duration of this game phase runs out
+	 */
+	void HandleGamePhaseExpired();
+
 public:
 	UFUNCTION(BlueprintNativeEvent, Category = "GamePhase")
 	void OnGamePhaseStart();
@@ -171,6 +462,14 @@ public:
 	void OnSubPhaseEnd(const FGameplayTag& SubPhaseTag);
 	virtual void OnSubPhaseEnd_Implementation(const FGameplayTag& SubPhaseTag) {}
 
+	UFUNCTION(BlueprintNativeEvent, Category = "GamePhase")
+	void OnGamePhaseExpired();
+	virtual void OnGamePhaseExpired_Implementation() {}
+
+	UFUNCTION(BlueprintNativeEvent, Category = "GamePhase")
+	void OnTickGamePhase(float DeltaTime);
+	virtual void OnTickGamePhase_Implementation(float DeltaTime) {}
+
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Utilities
@@ -0,0 +1,247 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseClassRegistry.h"
+
+#include "Phase/GamePhase.h"
+#include "Phase/GamePhaseBlueprint.h"
+#include "GEPhaseLogs.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Engine.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/NetConnection.h"
+#include "Engine/PendingNetGame.h"
+#include "Kismet/GameplayStatics.h"
+#include "UObject/UObjectHash.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GamePhaseClassRegistry)
+
+
+void UGamePhaseClassRegistry::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	auto& AssetRegistry{ FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get() };
+
+	// Wait for the initial scan in the editor so that every game phase blueprint is known
+
+	if (AssetRegistry.IsLoadingAssets())
+	{
+		FilesLoadedHandle = AssetRegistry.OnFilesLoaded().AddUObject(this, &ThisClass::HandleAssetRegistryFilesLoaded);
+	}
+
+	// Send the checksum to the server when connecting
+
+	PendingNetGameHandle = FNetDelegates::OnPendingNetGameConnectionCreated.AddUObject(this, &ThisClass::HandlePendingNetGameConnectionCreated);
+
+	RebuildRegistry();
+}
+
+void UGamePhaseClassRegistry::Deinitialize()
+{
+	if (FilesLoadedHandle.IsValid())
+	{
+		if (auto* AssetRegistryModule{ FModuleManager::GetModulePtr<FAssetRegistryModule>(TEXT("AssetRegistry")) })
+		{
+			AssetRegistryModule->Get().OnFilesLoaded().Remove(FilesLoadedHandle);
+		}
+
+		FilesLoadedHandle.Reset();
+	}
+
+	FNetDelegates::OnPendingNetGameConnectionCreated.Remove(PendingNetGameHandle);
+	PendingNetGameHandle.Reset();
+
+	ClassPaths.Reset();
+	ClassPathToNetId.Reset();
+	ResolvedClasses.Reset();
+
+	Super::Deinitialize();
+}
+
+UGamePhaseClassRegistry* UGamePhaseClassRegistry::Get()
+{
+	return GEngine ? GEngine->GetEngineSubsystem<UGamePhaseClassRegistry>() : nullptr;
+}
+
+
+void UGamePhaseClassRegistry::HandleAssetRegistryFilesLoaded()
+{
+	if (auto* AssetRegistryModule{ FModuleManager::GetModulePtr<FAssetRegistryModule>(TEXT("AssetRegistry")) })
+	{
+		AssetRegistryModule->Get().OnFilesLoaded().Remove(FilesLoadedHandle);
+	}
+
+	FilesLoadedHandle.Reset();
+
+	RebuildRegistry();
+}
+
+void UGamePhaseClassRegistry::HandlePendingNetGameConnectionCreated(UPendingNetGame* PendingNetGame)
+{
+	if (PendingNetGame)
+	{
+		PendingNetGame->URL.AddOption(*FString::Printf(TEXT("%s=%u"), *NAME_ChecksumOptionKey, Checksum));
+	}
+}
+
+void UGamePhaseClassRegistry::RebuildRegistry()
+{
+	TArray<FTopLevelAssetPath> FoundPaths;
+	TSet<FTopLevelAssetPath> NativePaths;
+
+	// Native classes
+
+	TArray<UClass*> NativeClasses;
+	GetDerivedClasses(UGamePhase::StaticClass(), NativeClasses, true);
+	NativeClasses.Add(UGamePhase::StaticClass());
+
+	for (const auto& Class : NativeClasses)
+	{
+		// Classes of editor-only modules, such as the test game phases, are not in cooked builds
+
+		if (Class->HasAnyClassFlags(CLASS_Native) && !Class->GetPackage()->HasAnyPackageFlags(PKG_EditorOnly))
+		{
+			NativePaths.Add(Class->GetClassPathName());
+
+			if (!Class->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated))
+			{
+				FoundPaths.Add(Class->GetClassPathName());
+			}
+		}
+	}
+
+	// Blueprint classes
+
+	auto& AssetRegistry{ FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get() };
+
+	TArray<FAssetData> BlueprintAssets;
+
+	if (FPlatformProperties::RequiresCookedData())
+	{
+		// Blueprint assets are stripped on cook, so look for generated classes with a native game phase parent
+
+		AssetRegistry.GetAssetsByClass(UBlueprintGeneratedClass::StaticClass()->GetClassPathName(), BlueprintAssets, true);
+
+		for (const auto& AssetData : BlueprintAssets)
+		{
+			const auto NativeParentPath{ AssetData.GetTagValueRef<FString>(FBlueprintTags::NativeParentClassPath) };
+
+			if (NativePaths.Contains(FTopLevelAssetPath(FPackageName::ExportTextPathToObjectPath(NativeParentPath))))
+			{
+				FoundPaths.Add(AssetData.GetSoftObjectPath().GetAssetPath());
+			}
+		}
+	}
+	else
+	{
+		AssetRegistry.GetAssetsByClass(UGamePhaseBlueprint::StaticClass()->GetClassPathName(), BlueprintAssets, true);
+
+		for (const auto& AssetData : BlueprintAssets)
+		{
+			const auto GeneratedClassPath{ AssetData.GetTagValueRef<FString>(FBlueprintTags::GeneratedClassPath) };
+
+			if (!GeneratedClassPath.IsEmpty())
+			{
+				FoundPaths.Add(FTopLevelAssetPath(FPackageName::ExportTextPathToObjectPath(GeneratedClassPath)));
+			}
+		}
+	}
+
+	// Number in order of path so that the IDs do not depend on the discovery order
+
+	FoundPaths.Sort(
+		[](const FTopLevelAssetPath& A, const FTopLevelAssetPath& B)
+		{
+			return A.Compare(B) < 0;
+		}
+	);
+
+	ClassPaths.Reset(FoundPaths.Num() + 1);
+	ClassPathToNetId.Reset();
+	ResolvedClasses.Reset();
+
+	ClassPaths.Add(FTopLevelAssetPath());
+
+	for (const auto& Path : FoundPaths)
+	{
+		if (ClassPaths.Num() > MAX_uint16)
+		{
+			UE_LOG(LogGameExt_GamePhase, Warning, TEXT("Too many game phase classes, the rest are replicated by reference."));
+			break;
+		}
+
+		if (!ClassPathToNetId.Contains(Path))
+		{
+			ClassPathToNetId.Add(Path, static_cast<uint16>(ClassPaths.Num()));
+			ClassPaths.Add(Path);
+		}
+	}
+
+	ResolvedClasses.SetNum(ClassPaths.Num());
+
+	// Paths are compared as strings so that the checksum does not depend on the name table of the process
+
+	Checksum = static_cast<uint32>(ClassPaths.Num());
+
+	for (const auto& Path : ClassPaths)
+	{
+		Checksum = FCrc::StrCrc32(*Path.ToString(), Checksum);
+	}
+
+	UE_LOG(LogGameExt_GamePhase, Log, TEXT("Game phase class registry built: %d classes (Checksum: %08x)"), GetNumRegisteredClasses(), Checksum);
+}
+
+uint16 UGamePhaseClassRegistry::GetNetIdForClass(const UClass* Class) const
+{
+	if (!Class)
+	{
+		return InvalidNetId;
+	}
+
+	const auto* NetId{ ClassPathToNetId.Find(Class->GetClassPathName()) };
+	return NetId ? *NetId : InvalidNetId;
+}
+
+TSubclassOf<UGamePhase> UGamePhaseClassRegistry::GetClassForNetId(uint16 NetId) const
+{
+	if ((NetId == InvalidNetId) || !ClassPaths.IsValidIndex(NetId))
+	{
+		return nullptr;
+	}
+
+	auto& ResolvedClass{ ResolvedClasses[NetId] };
+
+	// Never load here, since this is called while receiving replicated data
+
+	if (!ResolvedClass.IsValid())
+	{
+		ResolvedClass = TSoftClassPtr<UGamePhase>(FSoftObjectPath(ClassPaths[NetId])).Get();
+	}
+
+	return Cast<UClass>(ResolvedClass.Get());
+}
+
+FSoftObjectPath UGamePhaseClassRegistry::GetClassPathForNetId(uint16 NetId) const
+{
+	if ((NetId == InvalidNetId) || !ClassPaths.IsValidIndex(NetId))
+	{
+		return FSoftObjectPath();
+	}
+
+	return FSoftObjectPath(ClassPaths[NetId]);
+}
+
+bool UGamePhaseClassRegistry::DoesConnectionMatch(const UNetConnection* Connection) const
+{
+	if (!Connection)
+	{
+		return false;
+	}
+
+	// Clients that did not send the checksum are treated as not matching
+
+	const auto Value{ UGameplayStatics::ParseOption(Connection->RequestURL, NAME_ChecksumOptionKey) };
+
+	return !Value.IsEmpty() && (FCString::Strtoui64(*Value, nullptr, 10) == Checksum);
+}
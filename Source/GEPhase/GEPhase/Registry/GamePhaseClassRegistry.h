@@ -0,0 +1,122 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Subsystems/EngineSubsystem.h"
+
+#include "GamePhaseClassRegistry.generated.h"
+
+class UGamePhase;
+class UNetConnection;
+class UPendingNetGame;
+
+
+/**
+ * Subsystem that assigns compact network IDs to game phase classes
+ * 
+ * Tips:
+ *	Native game phase classes and the classes generated by game phase blueprints are collected from the asset registry
+ *	and numbered in order of their path, so that the server and clients running the same build agree on the IDs.
+ *	Native classes of editor-only modules are left out, since cooked builds do not have them.
+ *	ID 0 means that the class has no ID and must be replicated by reference.
+ * 
+ *	Clients send the checksum of their registry in the login URL, 
+ *	so that the server can turn away the clients that do not agree on the IDs.
+ */
+UCLASS()
+class GEPHASE_API UGamePhaseClassRegistry : public UEngineSubsystem
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseClassRegistry() {}
+
+	//
+	// Net ID of a class that is not registered
+	//
+	static constexpr uint16 InvalidNetId{ 0 };
+
+	//
+	// Key name of the login URL option that carries the checksum of the client registry
+	//
+	inline static const FString NAME_ChecksumOptionKey{ TEXT("GamePhaseRegistry") };
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * Returns the registry if the engine is running
+	 */
+	static UGamePhaseClassRegistry* Get();
+
+protected:
+	//
+	// Path of the class for each net ID
+	// 
+	// Tips:
+	//	Index 0 is reserved for InvalidNetId
+	//
+	TArray<FTopLevelAssetPath> ClassPaths;
+
+	//
+	// Net ID for each class path
+	//
+	TMap<FTopLevelAssetPath, uint16> ClassPathToNetId;
+
+	//
+	// Classes already resolved for each net ID
+	//
+	mutable TArray<TWeakObjectPtr<UClass>> ResolvedClasses;
+
+	//
+	// Checksum of the registered class paths in order of net ID
+	//
+	uint32 Checksum{ 0 };
+
+	FDelegateHandle FilesLoadedHandle;
+	FDelegateHandle PendingNetGameHandle;
+
+protected:
+	void HandleAssetRegistryFilesLoaded();
+	void HandlePendingNetGameConnectionCreated(UPendingNetGame* PendingNetGame);
+
+public:
+	/**
+	 * Collect game phase classes and reassign net IDs
+	 */
+	void RebuildRegistry();
+
+	/**
+	 * Returns the net ID of the class or InvalidNetId if it is not registered
+	 */
+	uint16 GetNetIdForClass(const UClass* Class) const;
+
+	/**
+	 * Returns the class of the net ID
+	 * 
+	 * Tips:
+	 *	Returns nullptr if the class is not loaded yet. 
+	 *	Use GetClassPathForNetId to load it in the background.
+	 */
+	TSubclassOf<UGamePhase> GetClassForNetId(uint16 NetId) const;
+
+	/**
+	 * Returns the path of the class of the net ID
+	 */
+	FSoftObjectPath GetClassPathForNetId(uint16 NetId) const;
+
+	/**
+	 * Returns the checksum of the registered class paths
+	 */
+	uint32 GetChecksum() const { return Checksum; }
+
+	/**
+	 * Returns whether the client of the connection sent the same registry checksum on login
+	 */
+	bool DoesConnectionMatch(const UNetConnection* Connection) const;
+
+	/**
+	 * Returns the number of registered classes
+	 */
+	int32 GetNumRegisteredClasses() const { return ClassPaths.Num() - 1; }
+
+};
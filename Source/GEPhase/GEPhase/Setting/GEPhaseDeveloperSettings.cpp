@@ -0,0 +1,12 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GEPhaseDeveloperSettings.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GEPhaseDeveloperSettings)
+
+
+UGEPhaseDeveloperSettings::UGEPhaseDeveloperSettings()
+{
+	CategoryName = FName(TEXT("Game"));
+	SectionName = FName(TEXT("Game Phase Extension"));
+}
@@ -0,0 +1,57 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Engine/DeveloperSettings.h"
+
+#include "Type/GamePhaseListenerTypes.h"
+
+#include "GEPhaseDeveloperSettings.generated.h"
+
+
+/**
+ * Settings for the Game Phase Extension plugin
+ */
+UCLASS(Config = "Game", Defaultconfig, meta = (DisplayName = "Game Phase Extension"))
+class GEPHASE_API UGEPhaseDeveloperSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+public:
+	UGEPhaseDeveloperSettings();
+
+	///////////////////////////////////////////////
+	// Event Delivery
+public:
+	//
+	// How game phase events are delivered to the listeners
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Event Delivery")
+	EGamePhaseEventDeliveryMode EventDeliveryMode{ EGamePhaseEventDeliveryMode::Immediate };
+
+	//
+	// Tick group in which queued game phase events are delivered
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Event Delivery", meta = (EditCondition = "EventDeliveryMode == EGamePhaseEventDeliveryMode::Queued"))
+	TEnumAsByte<ETickingGroup> EventFlushTickGroup{ TG_PrePhysics };
+
+	//
+	// Time budget per frame for delivering queued game phase events (in milliseconds)
+	// 
+	// Tips:
+	//	Events that do not fit in the budget are delivered in the next frame.
+	//	At least one event is delivered per frame. 0 means no limit.
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Event Delivery", meta = (ClampMin = 0.0, Units = "ms", EditCondition = "EventDeliveryMode == EGamePhaseEventDeliveryMode::Queued"))
+	float EventFlushBudgetMs{ 1.0f };
+
+
+	///////////////////////////////////////////////
+	// Prediction
+public:
+	//
+	// Seconds to wait for the server to confirm a predicted sub-phase before rolling it back
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Prediction", meta = (ClampMin = 0.1, Units = "s"))
+	float PredictionTimeout{ 2.0f };
+
+};
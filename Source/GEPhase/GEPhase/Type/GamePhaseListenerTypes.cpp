@@ -1,19 +1,199 @@
-// Copyright (C) 2024 owoDra
+﻿// Copyright (C) 2024 owoDra
 
 #include "GamePhaseListenerTypes.h"
 
 #include "GamePhaseSubsystem.h"
 
+#include "GameplayTagsManager.h"
+#include "Algo/AllOf.h"
+#include "Algo/AnyOf.h"
+
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GamePhaseListenerTypes)
 
 
+//////////////////////////////////////////////////////
+// FGamePhaseListenerData
+
+bool FGamePhaseListenerData::Invoke(FGameplayTag InGamePhaseTag, EGamePhaseEventType EventType) const
+{
+	if (NativeThunk)
+	{
+		auto* Object{ NativeOwner.Get() };
+		if (!Object)
+		{
+			return false;
+		}
+
+		NativeThunk(Object, NativeFuncStorage, InGamePhaseTag, EventType);
+	}
+	else if (ReceivedDelegate.IsBound())
+	{
+		ReceivedDelegate.Execute(InGamePhaseTag, EventType);
+	}
+	else if (ReceivedCallback)
+	{
+		ReceivedCallback(InGamePhaseTag, EventType);
+	}
+	else
+	{
+		// Only a delegate whose object no longer exists is left unbound
+
+		return false;
+	}
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////
+// FGamePhaseCompiledTagQuery
+
+void FGamePhaseCompiledTagQuery::Compile(const FGameplayTagQuery& Query, TBitArray<>& OutRelevantBits)
+{
+	Nodes.Reset();
+
+	if (Query.IsEmpty())
+	{
+		return;
+	}
+
+	FGameplayTagQueryExpression RootExpr;
+	Query.GetQueryExpr(RootExpr);
+
+	CompileExpr(RootExpr, OutRelevantBits);
+}
+
+void FGamePhaseCompiledTagQuery::CompileExpr(const FGameplayTagQueryExpression& Expr, TBitArray<>& OutRelevantBits)
+{
+	const auto NodeIndex{ Nodes.AddDefaulted() };
+	Nodes[NodeIndex].ExprType = Expr.ExprType;
+
+	if (Expr.UsesTagSet())
+	{
+		const auto& TagsManager{ UGameplayTagsManager::Get() };
+
+		for (const auto& Tag : Expr.TagSet)
+		{
+			const auto NetIndex{ static_cast<int32>(TagsManager.GetNetIndexFromTag(Tag)) };
+			const auto BitIndex{ (NetIndex != INVALID_TAGNETINDEX) ? NetIndex : INDEX_NONE };
+
+			Nodes[NodeIndex].TagBitIndices.Add(BitIndex);
+
+			if (BitIndex != INDEX_NONE)
+			{
+				if (BitIndex >= OutRelevantBits.Num())
+				{
+					OutRelevantBits.Add(false, BitIndex + 1 - OutRelevantBits.Num());
+				}
+
+				OutRelevantBits[BitIndex] = true;
+			}
+		}
+	}
+	else if (Expr.UsesExprSet())
+	{
+		for (const auto& SubExpr : Expr.ExprSet)
+		{
+			CompileExpr(SubExpr, OutRelevantBits);
+		}
+	}
+
+	Nodes[NodeIndex].EndIndex = Nodes.Num();
+}
+
+bool FGamePhaseCompiledTagQuery::Matches(const TBitArray<>& ExplicitBits, const TBitArray<>& ImplicitBits) const
+{
+	return !Nodes.IsEmpty() && MatchesNode(0, ExplicitBits, ImplicitBits);
+}
+
+bool FGamePhaseCompiledTagQuery::MatchesNode(int32 NodeIndex, const TBitArray<>& ExplicitBits, const TBitArray<>& ImplicitBits) const
+{
+	const auto& Node{ Nodes[NodeIndex] };
+
+	const auto HasBit
+	{
+		[](const TBitArray<>& Bits, int32 BitIndex)
+		{
+			return (BitIndex != INDEX_NONE) && (BitIndex < Bits.Num()) && Bits[BitIndex];
+		}
+	};
+
+	const auto HasAnyTag
+	{
+		[&Node, &HasBit](const TBitArray<>& Bits)
+		{
+			return Algo::AnyOf(Node.TagBitIndices, [&Bits, &HasBit](int32 BitIndex) { return HasBit(Bits, BitIndex); });
+		}
+	};
+
+	const auto HasAllTags
+	{
+		[&Node, &HasBit](const TBitArray<>& Bits)
+		{
+			return Algo::AllOf(Node.TagBitIndices, [&Bits, &HasBit](int32 BitIndex) { return HasBit(Bits, BitIndex); });
+		}
+	};
+
+	switch (Node.ExprType)
+	{
+	case EGameplayTagQueryExprType::AnyTagsMatch:
+		return HasAnyTag(ImplicitBits);
+
+	case EGameplayTagQueryExprType::AllTagsMatch:
+		return HasAllTags(ImplicitBits);
+
+	case EGameplayTagQueryExprType::NoTagsMatch:
+		return !HasAnyTag(ImplicitBits);
+
+	case EGameplayTagQueryExprType::AnyTagsExactMatch:
+		return HasAnyTag(ExplicitBits);
+
+	case EGameplayTagQueryExprType::AllTagsExactMatch:
+		return HasAllTags(ExplicitBits);
+
+	case EGameplayTagQueryExprType::AnyExprMatch:
+	case EGameplayTagQueryExprType::AllExprMatch:
+	case EGameplayTagQueryExprType::NoExprMatch:
+	{
+		// Any stops at the first match, All and No at the first mismatch and match respectively
+
+		for (auto ChildIndex{ NodeIndex + 1 }; ChildIndex < Node.EndIndex; ChildIndex = Nodes[ChildIndex].EndIndex)
+		{
+			const auto bMatched{ MatchesNode(ChildIndex, ExplicitBits, ImplicitBits) };
+
+			if ((Node.ExprType == EGameplayTagQueryExprType::AnyExprMatch) && bMatched)
+			{
+				return true;
+			}
+			else if ((Node.ExprType == EGameplayTagQueryExprType::AllExprMatch) && !bMatched)
+			{
+				return false;
+			}
+			else if ((Node.ExprType == EGameplayTagQueryExprType::NoExprMatch) && bMatched)
+			{
+				return false;
+			}
+		}
+
+		return (Node.ExprType != EGameplayTagQueryExprType::AnyExprMatch);
+	}
+
+	default:
+		return false;
+	}
+}
+
+
+//////////////////////////////////////////////////////
+// FGamePhaseListenerHandle
+
 void FGamePhaseListenerHandle::Unregister()
 {
 	if (auto* StrongSubsystem{ Subsystem.Get() })
 	{
 		StrongSubsystem->UnregisterListener(*this);
 		Subsystem.Reset();
-		GamePhaseTag = FGameplayTag();
-		ID = 0;
+		SlotIndex = INDEX_NONE;
+		Generation = 0;
 	}
 }
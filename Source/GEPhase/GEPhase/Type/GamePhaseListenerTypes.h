@@ -1,4 +1,4 @@
-// Copyright (C) 2024 owoDra
+﻿// Copyright (C) 2024 owoDra
 
 #pragma once
 
@@ -36,6 +36,88 @@ enum class EGamePhaseEventType : uint8
 };
 
 
+/**
+ * Ordering group of a listener
+ * 
+ * Tips:
+ *	Listeners in an earlier group receive events first.
+ *	Within the same group, listeners receive events in the order they were registered.
+ */
+UENUM(BlueprintType)
+enum class EGamePhaseListenerPriority : uint8
+{
+	Highest,
+
+	// For game rules that other systems depend on
+	Gameplay,
+
+	Default,
+
+	// For user interface
+	UI,
+
+	// For audio and other feedback
+	Audio,
+
+	Lowest
+};
+
+
+/**
+ * How game phase events are delivered to the listeners
+ */
+UENUM(BlueprintType)
+enum class EGamePhaseEventDeliveryMode : uint8
+{
+	// Events are delivered synchronously at the time the game phase changes
+	Immediate,
+
+	// Events are queued and delivered in order at a defined tick group within a per-frame time budget
+	Queued
+};
+
+
+/**
+ * Set of game phases ended and started by a single transition
+ */
+USTRUCT(BlueprintType)
+struct GEPHASE_API FGamePhaseTransition
+{
+	GENERATED_BODY()
+public:
+	FGamePhaseTransition() {}
+
+public:
+	//
+	// Game phases ended by this transition, in the order they ended
+	//
+	UPROPERTY(BlueprintReadOnly, Category = "GamePhase")
+	TArray<FGameplayTag> EndedPhaseTags;
+
+	//
+	// Game phases started by this transition, in the order they started
+	//
+	UPROPERTY(BlueprintReadOnly, Category = "GamePhase")
+	TArray<FGameplayTag> StartedPhaseTags;
+
+public:
+	bool IsEmpty() const { return EndedPhaseTags.IsEmpty() && StartedPhaseTags.IsEmpty(); }
+
+	void Reset()
+	{
+		EndedPhaseTags.Reset();
+		StartedPhaseTags.Reset();
+	}
+
+};
+
+
+/**
+ * Delegate to receive game phase events natively
+ */
+DECLARE_DELEGATE_TwoParams(FGamePhaseEventNativeDelegate, FGameplayTag, EGamePhaseEventType);
+
+
 /**
  * Entry information for a single registered listener
  */
@@ -52,8 +134,143 @@ public:
 	//
 	TFunction<void(FGameplayTag, EGamePhaseEventType)> ReceivedCallback;
 
-	int32 HandleID;
-	EGamePhaseTagMatchType MatchType;
+	//
+	// Callback for when a transition has been received
+	// 
+	// Tips:
+	//	Only set for transition listeners, which do not listen on a tag
+	//
+	TFunction<void(const FGamePhaseTransition&)> TransitionCallback;
+
+	//
+	// Delegate for when a message has been received
+	//
+	FGamePhaseEventNativeDelegate ReceivedDelegate;
+
+	//
+	// Object and member function bound for when a message has been received
+	// 
+	// Tips:
+	//	The member function pointer is stored inline in NativeFuncStorage and called through NativeThunk,
+	//	so that binding a member function requires no heap allocation.
+	//
+	static constexpr int32 NativeFuncStorageSize{ sizeof(void*) * 3 };
+
+	using FNativeThunk = void(*)(UObject*, const void*, FGameplayTag, EGamePhaseEventType);
+
+	FWeakObjectPtr NativeOwner;
+	FNativeThunk NativeThunk{ nullptr };
+	alignas(void*) uint8 NativeFuncStorage[NativeFuncStorageSize];
+
+	FGameplayTag GamePhaseTag;
+	EGamePhaseTagMatchType MatchType{ EGamePhaseTagMatchType::ExactMatch };
+
+	//
+	// Ordering group of this listener
+	//
+	EGamePhaseListenerPriority Priority{ EGamePhaseListenerPriority::Default };
+
+	//
+	// Registration order of this listener
+	//
+	int32 SerialNumber{ 0 };
+
+	//
+	// Generation of the slot that holds this listener
+	// 
+	// Tips:
+	//	Incremented each time the listener is unregistered so that stale handles to the slot can be detected
+	//
+	int32 Generation{ 1 };
+
+	//
+	// Whether this listener was unregistered and is waiting to be removed
+	//
+	bool bPendingRemoval{ false };
+
+public:
+	/**
+	 * Returns whether this listener is still registered
+	 */
+	bool IsAlive() const { return (SerialNumber != 0) && !bPendingRemoval; }
+
+	/**
+	 * Returns whether this listener receives events before the other
+	 */
+	bool Precedes(const FGamePhaseListenerData& Other) const
+	{
+		return (Priority != Other.Priority) ? (Priority < Other.Priority) : (SerialNumber < Other.SerialNumber);
+	}
+
+	/**
+	 * Notify this listener of a message
+	 * 
+	 * Tips:
+	 *	Returns false if the listener is bound to an object that no longer exists
+	 */
+	bool Invoke(FGameplayTag InGamePhaseTag, EGamePhaseEventType EventType) const;
+
+	/**
+	 * Returns whether this listener should receive events broadcast on the specified tag
+	 */
+	bool AppliesTo(const FGameplayTag& BroadcastTag) const
+	{
+		return (BroadcastTag == GamePhaseTag) || ((MatchType == EGamePhaseTagMatchType::PartialMatch) && BroadcastTag.MatchesTag(GamePhaseTag));
+	}
+
+};
+
+
+/**
+ * Gameplay tag query compiled to be evaluated against bits indexed by the net indices of the tags
+ * 
+ * Tips:
+ *	Exact tag expressions are evaluated against the bits of the tags themselves, 
+ *	and the other tag expressions against the bits of the tags and their parents.
+ */
+struct FGamePhaseCompiledTagQuery
+{
+public:
+	FGamePhaseCompiledTagQuery() {}
+
+protected:
+	struct FNode
+	{
+		EGameplayTagQueryExprType ExprType{ EGameplayTagQueryExprType::Undefined };
+
+		//
+		// Net indices of the tags of a tag expression, INDEX_NONE for tags without one
+		//
+		TArray<int32, TInlineAllocator<4>> TagBitIndices;
+
+		//
+		// Index of the node after the sub-expressions, which follow this node in Nodes
+		//
+		int32 EndIndex{ 0 };
+	};
+
+	//
+	// Expressions of the query in prefix order, empty if the query has no expression
+	//
+	TArray<FNode> Nodes;
+
+public:
+	/**
+	 * Compile the query and set the bits of the tags it references in OutRelevantBits
+	 */
+	void Compile(const FGameplayTagQuery& Query, TBitArray<>& OutRelevantBits);
+
+	/**
+	 * Returns whether the query matches the tags
+	 * 
+	 * Tips:
+	 *	Same result as FGameplayTagQuery::Matches for a container holding the tags of ExplicitBits
+	 */
+	bool Matches(const TBitArray<>& ExplicitBits, const TBitArray<>& ImplicitBits) const;
+
+protected:
+	void CompileExpr(const FGameplayTagQueryExpression& Expr, TBitArray<>& OutRelevantBits);
+	bool MatchesNode(int32 NodeIndex, const TBitArray<>& ExplicitBits, const TBitArray<>& ImplicitBits) const;
 
 };
 
@@ -71,27 +288,33 @@ struct GEPHASE_API FGamePhaseListenerHandle
 public:
 	FGamePhaseListenerHandle() {}
 
-	FGamePhaseListenerHandle(UGamePhaseSubsystem* InSubsystem, FGameplayTag InGamePhaseTag, int32 InID)
+	FGamePhaseListenerHandle(UGamePhaseSubsystem* InSubsystem, int32 InSlotIndex, int32 InGeneration)
 		: Subsystem(InSubsystem)
-		, GamePhaseTag(InGamePhaseTag)
-		, ID(InID)
+		, SlotIndex(InSlotIndex)
+		, Generation(InGeneration)
 	{}
 
 private:
 	UPROPERTY(Transient)
 	TWeakObjectPtr<UGamePhaseSubsystem> Subsystem;
 
+	//
+	// Index of the listener slot in the subsystem
+	//
 	UPROPERTY(Transient)
-	FGameplayTag GamePhaseTag;
+	int32 SlotIndex{ INDEX_NONE };
 
+	//
+	// Generation of the listener slot at the time of registration
+	//
 	UPROPERTY(Transient)
-	int32 ID{ 0 };
+	int32 Generation{ 0 };
 
 	FDelegateHandle StateClearedHandle;
 
 public:
 	void Unregister();
 
-	bool IsValid() const { return ID != 0; }
+	bool IsValid() const { return Generation != 0; }
 
 };
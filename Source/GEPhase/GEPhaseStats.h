@@ -0,0 +1,7 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("GamePhase"), STATGROUP_GamePhase, STATCAT_Advanced);
@@ -0,0 +1,37 @@
+﻿// Copyright (C) 2024 owoDra
+
+using UnrealBuildTool;
+
+public class GEPhaseTests : ModuleRules
+{
+	public GEPhaseTests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicIncludePaths.AddRange(
+            new string[]
+			{
+                ModuleDirectory,
+                ModuleDirectory + "/GEPhaseTests",
+            }
+        );
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+			}
+		);
+
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+                "Core", "CoreUObject", "Engine",
+
+                "GameplayTags", "GameplayTasks", "NetCore",
+
+                "GEPhase",
+            }
+		);
+	}
+}
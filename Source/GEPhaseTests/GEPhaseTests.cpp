@@ -0,0 +1,14 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GEPhaseTests.h"
+
+IMPLEMENT_MODULE(FGEPhaseTestsModule, GEPhaseTests)
+
+
+void FGEPhaseTestsModule::StartupModule()
+{
+}
+
+void FGEPhaseTestsModule::ShutdownModule()
+{
+}
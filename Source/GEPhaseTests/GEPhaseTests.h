@@ -0,0 +1,19 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Modules/ModuleManager.h"
+
+/**
+ *  Modules for the automation tests of the Game Phase Extension plugin
+ * 
+ * Tips:
+ *	Uncooked only, so that the test game phases are neither shipped nor listed in cooked builds
+ */
+class FGEPhaseTestsModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+
+};
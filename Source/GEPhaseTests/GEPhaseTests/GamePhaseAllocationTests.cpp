@@ -0,0 +1,91 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "GamePhaseTestTypes.h"
+#include "GamePhaseComponent.h"
+
+#include "GamePhaseSubsystem.h"
+#include "GEPhaseLogs.h"
+
+#include "Misc/AutomationTest.h"
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseAllocationTransitionTest, "GameExt.GamePhase.Allocation.Transition", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseAllocationTransitionTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Component{ TestWorld.Component };
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	Subsystem->SetEventDeliveryMode(EGamePhaseEventDeliveryMode::Immediate);
+
+	auto NumEvents{ 0 };
+
+	Subsystem->RegisterListener(TAG_GamePhaseTest_PooledSub,
+		[&NumEvents](FGameplayTag, EGamePhaseEventType)
+		{
+			++NumEvents;
+		});
+
+	// Replace the root with a sub-phase still active, and start and end a sub-phase under it
+
+	const auto RunCycle
+	{
+		[Component](const TSubclassOf<UGamePhase>& RootClass, const FGameplayTag& RootTag)
+		{
+			auto bSucceeded{ Component->SetGamePhase(RootClass) };
+			bSucceeded &= Component->AddSubPhase(UGamePhaseTest_PooledSub::StaticClass(), RootTag);
+			bSucceeded &= Component->EndPhaseByTag(TAG_GamePhaseTest_PooledSub);
+			bSucceeded &= Component->AddSubPhase(UGamePhaseTest_PooledSub::StaticClass(), RootTag);
+
+			return bSucceeded;
+		}
+	};
+
+	// Silence the start and end logs, since formatting them allocates
+
+	const auto Verbosity{ LogGameExt_GamePhase.GetVerbosity() };
+	LogGameExt_GamePhase.SetVerbosity(ELogVerbosity::Warning);
+
+	// Warm up the instance pools, the indices and the dispatch lists
+
+	auto bSucceeded{ true };
+
+	for (auto Idx{ 0 }; Idx < 4; ++Idx)
+	{
+		bSucceeded &= RunCycle(UGamePhaseTest_PooledRootA::StaticClass(), TAG_GamePhaseTest_PooledRootA);
+		bSucceeded &= RunCycle(UGamePhaseTest_PooledRootB::StaticClass(), TAG_GamePhaseTest_PooledRootB);
+	}
+
+	const auto NumPoolMisses{ Component->GetNumPoolMisses() };
+	const auto NumWarmUpEvents{ NumEvents };
+	auto NumAllocations{ 0 };
+
+	{
+		FGamePhaseScopedMallocCounter MallocCounter;
+
+		for (auto Idx{ 0 }; Idx < 100; ++Idx)
+		{
+			bSucceeded &= RunCycle(UGamePhaseTest_PooledRootA::StaticClass(), TAG_GamePhaseTest_PooledRootA);
+			bSucceeded &= RunCycle(UGamePhaseTest_PooledRootB::StaticClass(), TAG_GamePhaseTest_PooledRootB);
+		}
+
+		NumAllocations = MallocCounter.GetNumAllocations();
+	}
+
+	LogGameExt_GamePhase.SetVerbosity(Verbosity);
+
+	TestTrue(TEXT("All transitions succeed"), bSucceeded);
+	TestEqual(TEXT("Listener receives every start and end of the sub-phase"), NumEvents - NumWarmUpEvents, 200 * 4);
+	TestEqual(TEXT("Instances come from the pools"), Component->GetNumPoolMisses(), NumPoolMisses);
+	TestEqual(TEXT("Transitions do not allocate once warmed up"), NumAllocations, 0);
+
+	Component->EndAllGamePhases();
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
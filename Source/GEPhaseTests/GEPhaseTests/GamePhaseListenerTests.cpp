@@ -0,0 +1,346 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "GamePhaseTestTypes.h"
+#include "GamePhaseComponent.h"
+
+#include "GamePhaseSubsystem.h"
+
+#include "Misc/AutomationTest.h"
+
+
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_QueryParent, "GamePhase.Test.Query.Parent");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_QueryChild, "GamePhase.Test.Query.Parent.Child");
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseListenerUnregisterDuringCallbackTest, "GameExt.GamePhase.Listener.UnregisterDuringCallback", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseListenerUnregisterDuringCallbackTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	TArray<FString> Calls;
+	FGamePhaseListenerHandle HandleB;
+	FGamePhaseListenerHandle HandleC;
+
+	// A unregisters B, which has not been called yet, and C unregisters itself
+
+	Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+		[&](FGameplayTag, EGamePhaseEventType)
+		{
+			Calls.Add(TEXT("A"));
+			Subsystem->UnregisterListener(HandleB);
+		});
+
+	HandleB = Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+		[&](FGameplayTag, EGamePhaseEventType)
+		{
+			Calls.Add(TEXT("B"));
+		});
+
+	HandleC = Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+		[&](FGameplayTag, EGamePhaseEventType)
+		{
+			Calls.Add(TEXT("C"));
+			Subsystem->UnregisterListener(HandleC);
+		});
+
+	FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_RootA, EGamePhaseEventType::Start);
+
+	TestEqual(TEXT("Listener unregistered by an earlier callback is skipped"), FString::Join(Calls, TEXT(",")), FString(TEXT("A,C")));
+
+	FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_RootA, EGamePhaseEventType::End);
+
+	TestEqual(TEXT("Unregistered listeners are not called again"), FString::Join(Calls, TEXT(",")), FString(TEXT("A,C,A")));
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseListenerRegisterDuringCallbackTest, "GameExt.GamePhase.Listener.RegisterDuringCallback", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseListenerRegisterDuringCallbackTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	TArray<FString> Calls;
+	auto bRegistered{ false };
+
+	// A registers B with a higher priority, which must not receive the event in progress
+
+	Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+		[&](FGameplayTag, EGamePhaseEventType)
+		{
+			Calls.Add(TEXT("A"));
+
+			if (!bRegistered)
+			{
+				bRegistered = true;
+
+				Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+					[&](FGameplayTag, EGamePhaseEventType)
+					{
+						Calls.Add(TEXT("B"));
+					},
+					EGamePhaseTagMatchType::ExactMatch, false, EGamePhaseListenerPriority::Highest);
+			}
+		});
+
+	FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_RootA, EGamePhaseEventType::Start);
+
+	TestEqual(TEXT("Listener registered during a callback does not receive the event in progress"), FString::Join(Calls, TEXT(",")), FString(TEXT("A")));
+
+	FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_RootA, EGamePhaseEventType::End);
+
+	TestEqual(TEXT("Listener registered during a callback receives later events in priority order"), FString::Join(Calls, TEXT(",")), FString(TEXT("A,B,A")));
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseListenerNestedBroadcastTest, "GameExt.GamePhase.Listener.NestedBroadcast", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseListenerNestedBroadcastTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	TArray<FString> Calls;
+	FGamePhaseListenerHandle HandleC;
+
+	// A broadcasts on another tag, whose listener B unregisters C of the outer broadcast
+
+	Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+		[&](FGameplayTag, EGamePhaseEventType EventType)
+		{
+			Calls.Add(TEXT("A"));
+			FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_SubA, EventType);
+		});
+
+	Subsystem->RegisterListener(TAG_GamePhaseTest_SubA,
+		[&](FGameplayTag, EGamePhaseEventType)
+		{
+			Calls.Add(TEXT("B"));
+			Subsystem->UnregisterListener(HandleC);
+		});
+
+	HandleC = Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+		[&](FGameplayTag, EGamePhaseEventType)
+		{
+			Calls.Add(TEXT("C"));
+		});
+
+	Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+		[&](FGameplayTag, EGamePhaseEventType)
+		{
+			Calls.Add(TEXT("D"));
+		});
+
+	FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_RootA, EGamePhaseEventType::Start);
+
+	TestEqual(TEXT("Nested broadcast is delivered inside the outer one and its removals apply to the outer one"), FString::Join(Calls, TEXT(",")), FString(TEXT("A,B,D")));
+
+	FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_RootA, EGamePhaseEventType::End);
+
+	TestEqual(TEXT("Lists are intact after nested broadcasts"), FString::Join(Calls, TEXT(",")), FString(TEXT("A,B,D,A,B,D")));
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseListenerBroadcastAllocationTest, "GameExt.GamePhase.Listener.BroadcastAllocation", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseListenerBroadcastAllocationTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	auto NumCalls{ 0 };
+
+	for (auto Idx{ 0 }; Idx < 64; ++Idx)
+	{
+		Subsystem->RegisterListener(TAG_GamePhaseTest_RootA,
+			[&NumCalls](FGameplayTag, EGamePhaseEventType)
+			{
+				++NumCalls;
+			},
+			(Idx % 2 == 0) ? EGamePhaseTagMatchType::ExactMatch : EGamePhaseTagMatchType::PartialMatch);
+	}
+
+	// The first broadcast of a tag builds its dispatch list
+
+	FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_RootA, EGamePhaseEventType::Start);
+
+	const auto AllocatedSize{ FGamePhaseTestAccess::GetListenerAllocatedSize(Subsystem) };
+
+	for (auto Idx{ 0 }; Idx < 100; ++Idx)
+	{
+		FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, TAG_GamePhaseTest_RootA, (Idx % 2 == 0) ? EGamePhaseEventType::End : EGamePhaseEventType::Start);
+	}
+
+	TestEqual(TEXT("All listeners are called on every broadcast"), NumCalls, 64 * 101);
+	TestEqual(TEXT("Broadcasts do not grow the listener storage"), FGamePhaseTestAccess::GetListenerAllocatedSize(Subsystem), AllocatedSize);
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseListenerReplayWithQueuedEventsTest, "GameExt.GamePhase.Listener.ReplayWithQueuedEvents", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseListenerReplayWithQueuedEventsTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Component{ TestWorld.Component };
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	Subsystem->SetEventDeliveryMode(EGamePhaseEventDeliveryMode::Queued);
+
+	const auto TestTag{ TAG_GamePhaseTest_RootA.GetTag().RequestDirectParent() };
+
+	const auto Record
+	{
+		[](TArray<FString>& OutCalls)
+		{
+			return [&OutCalls](FGameplayTag GamePhaseTag, EGamePhaseEventType EventType)
+			{
+				OutCalls.Add(FString::Printf(TEXT("%s:%s"), (EventType == EGamePhaseEventType::Start) ? TEXT("Start") : TEXT("End"), *GamePhaseTag.ToString()));
+			};
+		}
+	};
+
+	// Nothing has been notified yet, so nothing is replayed and the queued Start is received once
+
+	TArray<FString> CallsA;
+
+	Component->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+	Subsystem->RegisterListener(TestTag, Record(CallsA), EGamePhaseTagMatchType::PartialMatch, true);
+
+	TestEqual(TEXT("Queued events are left to the flush"), CallsA.Num(), 0);
+	TestTrue(TEXT("Events are still queued"), Subsystem->HasQueuedGamePhaseEvents());
+
+	Subsystem->FlushQueuedGamePhaseEvents();
+
+	TestEqual(TEXT("Start is received once"), FString::Join(CallsA, TEXT(",")), FString(TEXT("Start:GamePhase.Test.RootA")));
+
+	// Only the notified game phase is replayed, and the queued one follows
+
+	TArray<FString> CallsB;
+
+	Component->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA);
+	Subsystem->RegisterListener(TestTag, Record(CallsB), EGamePhaseTagMatchType::PartialMatch, true);
+
+	TestEqual(TEXT("Notified game phase is replayed"), FString::Join(CallsB, TEXT(",")), FString(TEXT("Start:GamePhase.Test.RootA")));
+
+	Subsystem->FlushQueuedGamePhaseEvents();
+
+	TestEqual(TEXT("Queued game phase follows the replay"), FString::Join(CallsB, TEXT(",")), FString(TEXT("Start:GamePhase.Test.RootA,Start:GamePhase.Test.SubA")));
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseListenerQueryReplayWithQueuedEventsTest, "GameExt.GamePhase.Listener.QueryReplayWithQueuedEvents", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseListenerQueryReplayWithQueuedEventsTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Component{ TestWorld.Component };
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	Subsystem->SetEventDeliveryMode(EGamePhaseEventDeliveryMode::Queued);
+
+	const auto Query{ FGameplayTagQuery::MakeQuery_MatchTag(TAG_GamePhaseTest_RootA) };
+
+	const auto Record
+	{
+		[](TArray<FString>& OutCalls)
+		{
+			return [&OutCalls](FGameplayTag GamePhaseTag, EGamePhaseEventType EventType)
+			{
+				OutCalls.Add(FString::Printf(TEXT("%s:%s"), (EventType == EGamePhaseEventType::Start) ? TEXT("Start") : TEXT("End"), *GamePhaseTag.ToString()));
+			};
+		}
+	};
+
+	// The query matches only once the queued Start is delivered
+
+	TArray<FString> CallsA;
+
+	Component->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+	Subsystem->RegisterListener(Query, Record(CallsA), true);
+
+	TestEqual(TEXT("Queued events are left to the flush"), CallsA.Num(), 0);
+
+	Subsystem->FlushQueuedGamePhaseEvents();
+
+	TestEqual(TEXT("Start is received once"), FString::Join(CallsA, TEXT(",")), FString(TEXT("Start:GamePhase.Test.RootA")));
+
+	// The query matches as notified so far, and stops matching once the queued End is delivered
+
+	TArray<FString> CallsB;
+
+	Component->SetGamePhase(UGamePhaseTest_RootB::StaticClass());
+	Subsystem->RegisterListener(Query, Record(CallsB), true);
+
+	TestEqual(TEXT("Notified match is replayed"), FString::Join(CallsB, TEXT(",")), FString(TEXT("Start:GamePhase.Test.RootA")));
+
+	Subsystem->FlushQueuedGamePhaseEvents();
+
+	TestEqual(TEXT("Queued change follows the replay"), FString::Join(CallsB, TEXT(",")), FString(TEXT("Start:GamePhase.Test.RootA,End:GamePhase.Test.RootA")));
+	TestEqual(TEXT("Registered listener is notified as usual"), FString::Join(CallsA, TEXT(",")), FString(TEXT("Start:GamePhase.Test.RootA,End:GamePhase.Test.RootA")));
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseListenerQueryParentTagTest, "GameExt.GamePhase.Listener.QueryParentTag", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseListenerQueryParentTagTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Component{ TestWorld.Component };
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	Subsystem->SetEventDeliveryMode(EGamePhaseEventDeliveryMode::Immediate);
+
+	const auto Record
+	{
+		[](TArray<FString>& OutCalls)
+		{
+			return [&OutCalls](FGameplayTag GamePhaseTag, EGamePhaseEventType EventType)
+			{
+				OutCalls.Add(FString::Printf(TEXT("%s:%s"), (EventType == EGamePhaseEventType::Start) ? TEXT("Start") : TEXT("End"), *GamePhaseTag.ToString()));
+			};
+		}
+	};
+
+	Component->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+
+	TArray<FString> ExactCalls;
+	TArray<FString> PartialCalls;
+
+	Subsystem->RegisterListener(FGameplayTagQuery::MakeQuery_ExactMatchAnyTags(FGameplayTagContainer(TAG_GamePhaseTest_QueryParent)), Record(ExactCalls));
+	Subsystem->RegisterListener(FGameplayTagQuery::MakeQuery_MatchTag(TAG_GamePhaseTest_QueryParent), Record(PartialCalls));
+
+	// The child tag sets the bit of the parent tag, which only the partial query matches
+
+	FGamePhaseTestAccess::AddSubPhaseWithTag(Component, UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_QueryChild, TAG_GamePhaseTest_RootA);
+
+	TestEqual(TEXT("Exact query does not match the parent of an active tag"), ExactCalls.Num(), 0);
+	TestEqual(TEXT("Partial query matches the parent of an active tag"), FString::Join(PartialCalls, TEXT(",")), FString(TEXT("Start:GamePhase.Test.Query.Parent.Child")));
+
+	// Starting and ending the parent tag itself while the child is active is seen by the exact query only
+
+	FGamePhaseTestAccess::AddSubPhaseWithTag(Component, UGamePhaseTest_SubB::StaticClass(), TAG_GamePhaseTest_QueryParent, TAG_GamePhaseTest_RootA);
+	Component->EndPhaseByTag(TAG_GamePhaseTest_QueryParent);
+
+	TestEqual(TEXT("Exact query sees the parent tag start and end while the child is active"), FString::Join(ExactCalls, TEXT(",")), FString(TEXT("Start:GamePhase.Test.Query.Parent,End:GamePhase.Test.Query.Parent")));
+	TestEqual(TEXT("Partial query keeps matching through the child"), PartialCalls.Num(), 1);
+
+	Component->EndPhaseByTag(TAG_GamePhaseTest_QueryChild);
+
+	TestEqual(TEXT("Exact query is not notified when the child ends"), ExactCalls.Num(), 2);
+	TestEqual(TEXT("Partial query stops matching when the child ends"), FString::Join(PartialCalls, TEXT(",")), FString(TEXT("Start:GamePhase.Test.Query.Parent.Child,End:GamePhase.Test.Query.Parent.Child")));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,245 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "GamePhaseTestTypes.h"
+#include "GamePhaseComponent.h"
+
+#include "GamePhaseSubsystem.h"
+
+#include "Misc/AutomationTest.h"
+
+
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Depth7, "GamePhase.Test.Depth.D4.D5.D6.D7");
+
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf00, "GamePhase.Test.Perf.Sub00");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf01, "GamePhase.Test.Perf.Sub01");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf02, "GamePhase.Test.Perf.Sub02");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf03, "GamePhase.Test.Perf.Sub03");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf04, "GamePhase.Test.Perf.Sub04");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf05, "GamePhase.Test.Perf.Sub05");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf06, "GamePhase.Test.Perf.Sub06");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf07, "GamePhase.Test.Perf.Sub07");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf08, "GamePhase.Test.Perf.Sub08");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf09, "GamePhase.Test.Perf.Sub09");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf10, "GamePhase.Test.Perf.Sub10");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf11, "GamePhase.Test.Perf.Sub11");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf12, "GamePhase.Test.Perf.Sub12");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf13, "GamePhase.Test.Perf.Sub13");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf14, "GamePhase.Test.Perf.Sub14");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf15, "GamePhase.Test.Perf.Sub15");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf16, "GamePhase.Test.Perf.Sub16");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf17, "GamePhase.Test.Perf.Sub17");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf18, "GamePhase.Test.Perf.Sub18");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf19, "GamePhase.Test.Perf.Sub19");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf20, "GamePhase.Test.Perf.Sub20");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf21, "GamePhase.Test.Perf.Sub21");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf22, "GamePhase.Test.Perf.Sub22");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf23, "GamePhase.Test.Perf.Sub23");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf24, "GamePhase.Test.Perf.Sub24");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf25, "GamePhase.Test.Perf.Sub25");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf26, "GamePhase.Test.Perf.Sub26");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf27, "GamePhase.Test.Perf.Sub27");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf28, "GamePhase.Test.Perf.Sub28");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf29, "GamePhase.Test.Perf.Sub29");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf30, "GamePhase.Test.Perf.Sub30");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GamePhaseTest_Perf31, "GamePhase.Test.Perf.Sub31");
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseBroadcastPerfTest, "GameExt.GamePhase.Perf.Broadcast", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FGamePhaseBroadcastPerfTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumIterations{ 10000 };
+	const int32 ListenerCounts[]{ 1, 10, 100, 1000 };
+	const int32 BroadcastDepths[]{ 2, 4, 7 };
+
+	// Tags from GamePhase (depth 1) down to the deepest test tag (depth 7)
+
+	TArray<FGameplayTag> TagsByDepth;
+
+	for (FGameplayTag Tag{ TAG_GamePhaseTest_Depth7 }; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+	{
+		TagsByDepth.Insert(Tag, 0);
+	}
+
+	TagsByDepth.Insert(FGameplayTag::EmptyTag, 0);
+
+	for (const auto& NumListeners : ListenerCounts)
+	{
+		FGamePhaseTestWorld TestWorld;
+		auto* Subsystem{ TestWorld.Subsystem };
+
+		auto NumCalls{ 0 };
+
+		// Spread the listeners over the tags of every depth, half exact and half partial match
+
+		TArray<int32> NumExactAtDepth;
+		TArray<int32> NumPartialAtDepth;
+		NumExactAtDepth.SetNumZeroed(TagsByDepth.Num());
+		NumPartialAtDepth.SetNumZeroed(TagsByDepth.Num());
+
+		for (auto Idx{ 0 }; Idx < NumListeners; ++Idx)
+		{
+			const auto Depth{ 1 + (Idx / 2) % (TagsByDepth.Num() - 1) };
+			const auto bPartial{ (Idx % 2) == 1 };
+
+			Subsystem->RegisterListener(TagsByDepth[Depth],
+				[&NumCalls](FGameplayTag, EGamePhaseEventType)
+				{
+					++NumCalls;
+				},
+				bPartial ? EGamePhaseTagMatchType::PartialMatch : EGamePhaseTagMatchType::ExactMatch);
+
+			++(bPartial ? NumPartialAtDepth : NumExactAtDepth)[Depth];
+		}
+
+		for (const auto& Depth : BroadcastDepths)
+		{
+			const auto& BroadcastTag{ TagsByDepth[Depth] };
+
+			auto NumNotified{ NumExactAtDepth[Depth] };
+
+			for (auto AncestorDepth{ 1 }; AncestorDepth <= Depth; ++AncestorDepth)
+			{
+				NumNotified += NumPartialAtDepth[AncestorDepth];
+			}
+
+			// The first broadcast of a tag builds its dispatch list
+
+			const auto BuildStartTime{ FPlatformTime::Seconds() };
+
+			FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, BroadcastTag, EGamePhaseEventType::Start);
+
+			const auto BuildTime{ FPlatformTime::Seconds() - BuildStartTime };
+
+			NumCalls = 0;
+
+			const auto StartTime{ FPlatformTime::Seconds() };
+
+			for (auto Idx{ 0 }; Idx < NumIterations; ++Idx)
+			{
+				FGamePhaseTestAccess::BroadcastGamePhaseEvent(Subsystem, BroadcastTag, (Idx % 2 == 0) ? EGamePhaseEventType::End : EGamePhaseEventType::Start);
+			}
+
+			const auto Time{ FPlatformTime::Seconds() - StartTime };
+
+			TestEqual(FString::Printf(TEXT("Listeners notified (Listeners: %d, Depth: %d)"), NumListeners, Depth), NumCalls, NumNotified * NumIterations);
+
+			AddInfo(FString::Printf(TEXT("Listeners: %4d, Depth: %d, Notified: %4d | %8.1f ns/broadcast, %6.2f ns/listener, first broadcast %8.1f ns")
+				, NumListeners, Depth, NumNotified
+				, Time * 1.0e9 / NumIterations
+				, (NumNotified > 0) ? (Time * 1.0e9 / NumIterations / NumNotified) : 0.0
+				, BuildTime * 1.0e9));
+		}
+	}
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseContainerPerfTest, "GameExt.GamePhase.Perf.Container", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FGamePhaseContainerPerfTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumLookupIterations{ 100000 };
+	constexpr int32 NumCycleIterations{ 1000 };
+	const int32 SubPhaseCounts[]{ 0, 8, 32 };
+
+	const FGameplayTag FillerTags[]
+	{
+		TAG_GamePhaseTest_Perf00,
+		TAG_GamePhaseTest_Perf01,
+		TAG_GamePhaseTest_Perf02,
+		TAG_GamePhaseTest_Perf03,
+		TAG_GamePhaseTest_Perf04,
+		TAG_GamePhaseTest_Perf05,
+		TAG_GamePhaseTest_Perf06,
+		TAG_GamePhaseTest_Perf07,
+		TAG_GamePhaseTest_Perf08,
+		TAG_GamePhaseTest_Perf09,
+		TAG_GamePhaseTest_Perf10,
+		TAG_GamePhaseTest_Perf11,
+		TAG_GamePhaseTest_Perf12,
+		TAG_GamePhaseTest_Perf13,
+		TAG_GamePhaseTest_Perf14,
+		TAG_GamePhaseTest_Perf15,
+		TAG_GamePhaseTest_Perf16,
+		TAG_GamePhaseTest_Perf17,
+		TAG_GamePhaseTest_Perf18,
+		TAG_GamePhaseTest_Perf19,
+		TAG_GamePhaseTest_Perf20,
+		TAG_GamePhaseTest_Perf21,
+		TAG_GamePhaseTest_Perf22,
+		TAG_GamePhaseTest_Perf23,
+		TAG_GamePhaseTest_Perf24,
+		TAG_GamePhaseTest_Perf25,
+		TAG_GamePhaseTest_Perf26,
+		TAG_GamePhaseTest_Perf27,
+		TAG_GamePhaseTest_Perf28,
+		TAG_GamePhaseTest_Perf29,
+		TAG_GamePhaseTest_Perf30,
+		TAG_GamePhaseTest_Perf31,
+	};
+
+	for (const auto& NumSubPhases : SubPhaseCounts)
+	{
+		FGamePhaseTestWorld TestWorld;
+		auto* Component{ TestWorld.Component };
+
+		Component->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+
+		// Fill the container with sub-phases of the root, each nesting a sub-phase of its own every other time
+
+		for (auto Idx{ 0 }; Idx < NumSubPhases; ++Idx)
+		{
+			const auto& ParentTag{ ((Idx % 2) == 1) ? FillerTags[Idx - 1] : TAG_GamePhaseTest_RootA.GetTag() };
+
+			FGamePhaseTestAccess::AddSubPhaseWithTag(Component, UGamePhaseTest_SubB::StaticClass(), FillerTags[Idx], ParentTag);
+		}
+
+		TestEqual(FString::Printf(TEXT("Active game phases (Sub-phases: %d)"), NumSubPhases), FGamePhaseTestAccess::GetContainer(Component).Entries.Num(), NumSubPhases + 1);
+
+		// Lookups by tag
+
+		const auto& LookupTag{ (NumSubPhases > 0) ? FillerTags[NumSubPhases - 1] : TAG_GamePhaseTest_RootA.GetTag() };
+
+		auto NumFound{ 0 };
+
+		const auto LookupStartTime{ FPlatformTime::Seconds() };
+
+		for (auto Idx{ 0 }; Idx < NumLookupIterations; ++Idx)
+		{
+			NumFound += (FGamePhaseTestAccess::FindEntryByTag(Component, LookupTag) != nullptr) ? 1 : 0;
+		}
+
+		const auto LookupTime{ FPlatformTime::Seconds() - LookupStartTime };
+
+		TestEqual(FString::Printf(TEXT("Lookups found (Sub-phases: %d)"), NumSubPhases), NumFound, NumLookupIterations);
+
+		// Adding and ending a sub-phase
+
+		auto bAllSucceeded{ true };
+
+		const auto CycleStartTime{ FPlatformTime::Seconds() };
+
+		for (auto Idx{ 0 }; Idx < NumCycleIterations; ++Idx)
+		{
+			bAllSucceeded &= Component->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA);
+			bAllSucceeded &= Component->EndPhaseByTag(TAG_GamePhaseTest_SubA);
+		}
+
+		const auto CycleTime{ FPlatformTime::Seconds() - CycleStartTime };
+
+		TestTrue(FString::Printf(TEXT("Sub-phase added and ended (Sub-phases: %d)"), NumSubPhases), bAllSucceeded);
+
+		AddInfo(FString::Printf(TEXT("Sub-phases: %2d | %6.1f ns/lookup, %8.1f ns/add and end")
+			, NumSubPhases
+			, LookupTime * 1.0e9 / NumLookupIterations
+			, CycleTime * 1.0e9 / NumCycleIterations));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,288 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "GamePhaseTestTypes.h"
+#include "GamePhaseComponent.h"
+
+#include "GamePhaseSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/AutomationTest.h"
+
+
+namespace GamePhaseReplicationTests
+{
+	/**
+	 * Record the start and end of the test game phases as "Start:RootA" and so on
+	 */
+	void RecordEvents(UGamePhaseSubsystem* Subsystem, TArray<FString>& OutEvents)
+	{
+		const auto Record
+		{
+			[&OutEvents](FGameplayTag GamePhaseTag, EGamePhaseEventType EventType)
+			{
+				auto TagName{ GamePhaseTag.ToString() };
+				TagName.RightChopInline(TagName.Find(TEXT("."), ESearchCase::CaseSensitive, ESearchDir::FromEnd) + 1);
+
+				OutEvents.Add(FString::Printf(TEXT("%s:%s"), (EventType == EGamePhaseEventType::Start) ? TEXT("Start") : TEXT("End"), *TagName));
+			}
+		};
+
+		Subsystem->RegisterListener(TAG_GamePhaseTest_RootA, Record);
+		Subsystem->RegisterListener(TAG_GamePhaseTest_RootB, Record);
+		Subsystem->RegisterListener(TAG_GamePhaseTest_SubA, Record);
+		Subsystem->RegisterListener(TAG_GamePhaseTest_SubB, Record);
+	}
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseReplicationRemoveAndAddTest, "GameExt.GamePhase.Replication.RemoveAndAdd", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseReplicationRemoveAndAddTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld ServerWorld;
+	FGamePhaseTestWorld ClientWorld(false);
+
+	auto* Server{ ServerWorld.Component };
+	auto* Client{ ClientWorld.Component };
+
+	Server->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+	Server->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA);
+
+	FGamePhaseTestAccess::ReplicateAll(Server, Client);
+
+	TestNotNull(TEXT("Sub-phase is replicated"), Client->FindGamePhaseByTag(TAG_GamePhaseTest_SubA));
+
+	// The new game phase is added after the ended ones, so it is moved by the removal of the serializer
+
+	Server->SetGamePhase(UGamePhaseTest_RootB::StaticClass());
+
+	FGamePhaseTestAccess::ReplicateAll(Server, Client);
+
+	TestEqual(TEXT("Only the new game phase remains"), FGamePhaseTestAccess::GetContainer(Client).Entries.Num(), 1);
+	TestNull(TEXT("Removed game phase is not found"), Client->FindGamePhaseByTag(TAG_GamePhaseTest_RootA));
+	TestNull(TEXT("Removed sub-phase is not found"), Client->FindGamePhaseByTag(TAG_GamePhaseTest_SubA));
+
+	const auto* NewGamePhase{ Client->FindGamePhaseByTag(TAG_GamePhaseTest_RootB) };
+
+	TestTrue(TEXT("New game phase is found at its index after the removal"), IsValid(NewGamePhase) && NewGamePhase->IsA<UGamePhaseTest_RootB>());
+	TestTrue(TEXT("Current game phase is the new one"), Client->GetCurrentGamePhaseClass() == UGamePhaseTest_RootB::StaticClass());
+
+	// Sub-phases can be linked to the moved entry
+
+	Server->AddSubPhase(UGamePhaseTest_SubB::StaticClass(), TAG_GamePhaseTest_RootB);
+
+	FGamePhaseTestAccess::ReplicateAll(Server, Client);
+
+	TestTrue(TEXT("Sub-phase of the moved entry finds its parent"), Client->GetParentPhaseTag(TAG_GamePhaseTest_SubB) == TAG_GamePhaseTest_RootB);
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseReplicationOutOfOrderTest, "GameExt.GamePhase.Replication.OutOfOrder", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseReplicationOutOfOrderTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld ServerWorld;
+	auto* Server{ ServerWorld.Component };
+
+	Server->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+	Server->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA);
+	Server->AddSubPhase(UGamePhaseTest_SubB::StaticClass(), TAG_GamePhaseTest_SubA, 10.0f);
+
+	const auto RootA{ FGamePhaseTestAccess::FindReplicatedCopy(Server, TAG_GamePhaseTest_RootA) };
+	const auto SubA{ FGamePhaseTestAccess::FindReplicatedCopy(Server, TAG_GamePhaseTest_SubA) };
+	const auto SubB{ FGamePhaseTestAccess::FindReplicatedCopy(Server, TAG_GamePhaseTest_SubB) };
+
+	// Each entry arrives in its own update, deepest first
+
+	{
+		FGamePhaseTestWorld ClientWorld(false);
+		auto* Client{ ClientWorld.Component };
+
+		TArray<FString> Events;
+		GamePhaseReplicationTests::RecordEvents(ClientWorld.Subsystem, Events);
+
+		FGamePhaseTestAccess::ReceiveUpdate(Client, { SubB }, {});
+
+		TestTrue(TEXT("Sub-phase waits for its parent"), Events.IsEmpty() && !Client->FindGamePhaseByTag(TAG_GamePhaseTest_SubB));
+
+		// A change to an entry that has not started yet is kept until it starts
+
+		FGamePhaseTestAccess::ReceiveUpdate(Client, { SubA }, {}, { SubB });
+
+		TestTrue(TEXT("Sub-phase waits for its grandparent"), Events.IsEmpty() && !Client->FindGamePhaseByTag(TAG_GamePhaseTest_SubA));
+
+		FGamePhaseTestAccess::ReceiveUpdate(Client, { RootA }, {});
+
+		TestEqual(TEXT("Deferred sub-phases start after their parent in server order"), FString::Join(Events, TEXT(",")), FString(TEXT("Start:RootA,Start:SubA,Start:SubB")));
+
+		const auto* SubBInstance{ Client->FindGamePhaseByTag(TAG_GamePhaseTest_SubB) };
+
+		TestTrue(TEXT("Deferred sub-phase starts with the replicated timing"), SubBInstance && FMath::IsNearlyEqual(SubBInstance->GetDuration(), 10.0f));
+	}
+
+	// All entries arrive in a single update in reverse server order
+
+	{
+		FGamePhaseTestWorld ClientWorld(false);
+		auto* Client{ ClientWorld.Component };
+
+		TArray<FString> Events;
+		GamePhaseReplicationTests::RecordEvents(ClientWorld.Subsystem, Events);
+
+		FGamePhaseTestAccess::ReceiveUpdate(Client, { SubB, SubA, RootA }, {});
+
+		TestEqual(TEXT("Entries of a single update start in server order"), FString::Join(Events, TEXT(",")), FString(TEXT("Start:RootA,Start:SubA,Start:SubB")));
+	}
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseReplicationMissingUpdateTest, "GameExt.GamePhase.Replication.MissingUpdate", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseReplicationMissingUpdateTest::RunTest(const FString& Parameters)
+{
+	// Intermediate states that the client never receives are skipped
+
+	{
+		FGamePhaseTestWorld ServerWorld;
+		FGamePhaseTestWorld ClientWorld(false);
+
+		auto* Server{ ServerWorld.Component };
+		auto* Client{ ClientWorld.Component };
+
+		TArray<FString> Events;
+		GamePhaseReplicationTests::RecordEvents(ClientWorld.Subsystem, Events);
+
+		Server->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+		Server->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA);
+
+		FGamePhaseTestAccess::ReplicateAll(Server, Client);
+		Events.Reset();
+
+		Server->EndPhaseByTag(TAG_GamePhaseTest_SubA);
+		Server->AddSubPhase(UGamePhaseTest_SubB::StaticClass(), TAG_GamePhaseTest_RootA);
+		Server->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_SubB);
+		Server->EndPhaseByTag(TAG_GamePhaseTest_SubA);
+
+		FGamePhaseTestAccess::ReplicateAll(Server, Client);
+
+		TestEqual(TEXT("Only the difference to the last received state is applied"), FString::Join(Events, TEXT(",")), FString(TEXT("End:SubA,Start:SubB")));
+		TestTrue(TEXT("Client matches the server"), Client->GetParentPhaseTag(TAG_GamePhaseTest_SubB) == TAG_GamePhaseTest_RootA);
+		TestNull(TEXT("Game phase started and ended between updates is not active"), Client->FindGamePhaseByTag(TAG_GamePhaseTest_SubA));
+	}
+
+	// The parent of a deferred sub-phase never arrives because the sub-phase ended before the next update
+
+	{
+		FGamePhaseTestWorld ServerWorld;
+		FGamePhaseTestWorld ClientWorld(false);
+
+		auto* Server{ ServerWorld.Component };
+		auto* Client{ ClientWorld.Component };
+
+		TArray<FString> Events;
+		GamePhaseReplicationTests::RecordEvents(ClientWorld.Subsystem, Events);
+
+		Server->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+		Server->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA);
+
+		const auto RootA{ FGamePhaseTestAccess::FindReplicatedCopy(Server, TAG_GamePhaseTest_RootA) };
+		const auto SubA{ FGamePhaseTestAccess::FindReplicatedCopy(Server, TAG_GamePhaseTest_SubA) };
+
+		FGamePhaseTestAccess::ReceiveUpdate(Client, { SubA }, {});
+
+		Server->EndPhaseByTag(TAG_GamePhaseTest_SubA);
+
+		FGamePhaseTestAccess::ReceiveUpdate(Client, { RootA }, { SubA.ReplicationID });
+
+		TestEqual(TEXT("Removed sub-phase is neither started nor ended"), FString::Join(Events, TEXT(",")), FString(TEXT("Start:RootA")));
+		TestEqual(TEXT("Removed sub-phase is no longer waiting"), FGamePhaseTestAccess::GetContainer(Client).Entries.Num(), 1);
+
+		// Later updates do not start the removed sub-phase
+
+		Server->AddSubPhase(UGamePhaseTest_SubB::StaticClass(), TAG_GamePhaseTest_RootA);
+
+		FGamePhaseTestAccess::ReplicateAll(Server, Client);
+
+		TestEqual(TEXT("Only the new sub-phase starts"), FString::Join(Events, TEXT(",")), FString(TEXT("Start:RootA,Start:SubB")));
+	}
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseReplicationRelevantPlayersTest, "GameExt.GamePhase.Replication.RelevantPlayers", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseReplicationRelevantPlayersTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld ServerWorld;
+
+	auto* Server{ ServerWorld.Component };
+
+	const auto* PlayerA{ ServerWorld.World->SpawnActor<APlayerController>() };
+	const auto* PlayerB{ ServerWorld.World->SpawnActor<APlayerController>() };
+
+	Server->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+	Server->AddSubPhase(UGamePhaseTest_RelevantSub::StaticClass(), TAG_GamePhaseTest_RootA);
+	Server->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RelevantSub);
+
+	auto* RelevantSub{ Cast<UGamePhaseTest_RelevantSub>(Server->FindGamePhaseByTag(TAG_GamePhaseTest_RelevantSub)) };
+
+	if (!TestNotNull(TEXT("Game phase for relevant players is started"), RelevantSub))
+	{
+		return true;
+	}
+
+	RelevantSub->RelevantPlayer = PlayerA;
+
+	// Sub-phases of a game phase for relevant players follow its relevancy
+
+	TestTrue(TEXT("Game phase for all players is sent to every player"), FGamePhaseTestAccess::ShouldReplicateTo(Server, TAG_GamePhaseTest_RootA, PlayerB));
+	TestTrue(TEXT("Game phase is sent to the relevant player"), FGamePhaseTestAccess::ShouldReplicateTo(Server, TAG_GamePhaseTest_RelevantSub, PlayerA));
+	TestTrue(TEXT("Sub-phase is sent to the relevant player"), FGamePhaseTestAccess::ShouldReplicateTo(Server, TAG_GamePhaseTest_SubA, PlayerA));
+	TestFalse(TEXT("Game phase is kept from the other player"), FGamePhaseTestAccess::ShouldReplicateTo(Server, TAG_GamePhaseTest_RelevantSub, PlayerB));
+	TestFalse(TEXT("Sub-phase is kept from the other player"), FGamePhaseTestAccess::ShouldReplicateTo(Server, TAG_GamePhaseTest_SubA, PlayerB));
+	TestFalse(TEXT("Game phase is kept from connections without a player"), FGamePhaseTestAccess::ShouldReplicateTo(Server, TAG_GamePhaseTest_RelevantSub, nullptr));
+
+	// The relevancy follows the game phase once it is refreshed
+
+	RelevantSub->RelevantPlayer = PlayerB;
+	Server->RefreshGamePhaseRelevancy();
+
+	TestFalse(TEXT("Game phase is kept from the player it is no longer relevant to"), FGamePhaseTestAccess::ShouldReplicateTo(Server, TAG_GamePhaseTest_SubA, PlayerA));
+	TestTrue(TEXT("Game phase is sent to the player it became relevant to"), FGamePhaseTestAccess::ShouldReplicateTo(Server, TAG_GamePhaseTest_SubA, PlayerB));
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseReplicationItemSizeTest, "GameExt.GamePhase.Replication.ItemSize", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseReplicationItemSizeTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld ServerWorld;
+
+	auto* Server{ ServerWorld.Component };
+
+	Server->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+	Server->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA);
+
+	const auto ById{ FGamePhaseTestAccess::FindReplicatedCopyByNetId(Server, TAG_GamePhaseTest_SubA) };
+	const auto ByReference{ FGamePhaseTestAccess::FindReplicatedCopyByReference(Server, TAG_GamePhaseTest_SubA) };
+
+	// Each transition replicates one entry, so its size is the size of the transition on the wire
+
+	const auto BitsById{ FGamePhaseTestAccess::GetSerializedBits(ById) };
+	const auto BitsByReference{ FGamePhaseTestAccess::GetSerializedBits(ByReference) };
+
+	AddInfo(FString::Printf(TEXT("Sub-phase entry: %lld bytes with net IDs, %lld bytes by reference"), (BitsById + 7) / 8, (BitsByReference + 7) / 8));
+
+	TestTrue(TEXT("Entry with net IDs is smaller than the entry by reference"), BitsById < BitsByReference);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
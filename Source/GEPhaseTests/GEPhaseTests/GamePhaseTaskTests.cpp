@@ -0,0 +1,50 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "GamePhaseTestTypes.h"
+#include "GamePhaseComponent.h"
+
+#include "Misc/AutomationTest.h"
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseTaskEndSpawnedWhileEndingTest, "GameExt.GamePhase.Task.EndSpawnedWhileEnding", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseTaskEndSpawnedWhileEndingTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Component{ TestWorld.Component };
+
+	Component->SetGamePhase(UGamePhaseTest_RootA::StaticClass());
+
+	auto* GamePhase{ Component->FindGamePhaseByTag(TAG_GamePhaseTest_RootA) };
+
+	if (!TestNotNull(TEXT("Game phase is started"), GamePhase))
+	{
+		return true;
+	}
+
+	// The task starts another task of the game phase when the game phase ends it
+
+	auto* Task{ UGameplayTask::NewTask<UGamePhaseTest_Task>(*GamePhase) };
+	Task->bSpawnOnOwnerEnded = true;
+	Task->ReadyForActivation();
+
+	TestEqual(TEXT("Task is active"), GamePhase->GetNumLiveTasks(), 1);
+
+	Component->EndAllGamePhases();
+
+	TestTrue(TEXT("Task is ended with its game phase"), Task->IsFinished());
+
+	if (TestNotNull(TEXT("Ending task starts another task"), Task->SpawnedTask.Get()))
+	{
+		TestTrue(TEXT("Task started while ending the others is ended too"), Task->SpawnedTask->IsFinished());
+	}
+
+	TestEqual(TEXT("No task is left"), GamePhase->GetNumLiveTasks(), 0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,503 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "GamePhaseTestTypes.h"
+#include "GamePhaseComponent.h"
+#include "GamePhaseSubsystem.h"
+#include "Registry/GamePhaseClassRegistry.h"
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include "UObject/CoreNet.h"
+
+
+//////////////////////////////////////////////////////
+// FGamePhaseTestWorld
+
+#pragma region FGamePhaseTestWorld
+
+FGamePhaseTestWorld::FGamePhaseTestWorld(bool bAuthority)
+{
+	World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("GamePhaseTestWorld"));
+	check(World);
+
+	auto& WorldContext{ GEngine->CreateNewWorldContext(EWorldType::Game) };
+	WorldContext.SetCurrentWorld(World);
+
+	World->InitializeActorsForPlay(FURL());
+
+	GameState = World->SpawnActor<AGameStateBase>();
+	check(GameState);
+
+	if (!bAuthority)
+	{
+		GameState->SetRole(ROLE_SimulatedProxy);
+	}
+
+	World->SetGameState(GameState);
+
+	Component = NewObject<UGamePhaseComponent>(GameState);
+	Component->RegisterComponent();
+
+	Subsystem = World->GetSubsystem<UGamePhaseSubsystem>();
+	check(Subsystem);
+}
+
+FGamePhaseTestWorld::~FGamePhaseTestWorld()
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////
+// FGamePhaseScopedMallocCounter
+
+#pragma region FGamePhaseScopedMallocCounter
+
+/**
+ * Allocator that forwards to the allocator it replaces and counts the allocations of a single thread
+ */
+class FGamePhaseCountingMalloc final : public FMalloc
+{
+public:
+	FMalloc* InnerMalloc{ nullptr };
+	uint32 CountedThreadId{ 0 };
+	int32 NumAllocations{ 0 };
+
+public:
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		// Realloc to zero frees the memory
+
+		if (Count > 0)
+		{
+			CountAllocation();
+		}
+
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		InnerMalloc->Trim(bTrimThreadCaches);
+	}
+
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->SetupTLSCachesOnCurrentThread();
+	}
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual bool ValidateHeap() override
+	{
+		return InnerMalloc->ValidateHeap();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("GamePhaseCountingMalloc");
+	}
+
+private:
+	void CountAllocation()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == CountedThreadId)
+		{
+			++NumAllocations;
+		}
+	}
+
+};
+
+/**
+ * Returns the proxy allocator
+ * 
+ * Tips:
+ *	Never destroyed, since other threads may still be inside it right after GMalloc is restored
+ */
+static FGamePhaseCountingMalloc& GetCountingMalloc()
+{
+	static FGamePhaseCountingMalloc CountingMalloc;
+	return CountingMalloc;
+}
+
+FGamePhaseScopedMallocCounter::FGamePhaseScopedMallocCounter()
+{
+	auto& CountingMalloc{ GetCountingMalloc() };
+	check(GMalloc != &CountingMalloc);
+
+	CountingMalloc.InnerMalloc = GMalloc;
+	CountingMalloc.CountedThreadId = FPlatformTLS::GetCurrentThreadId();
+	CountingMalloc.NumAllocations = 0;
+
+	GMalloc = &CountingMalloc;
+}
+
+FGamePhaseScopedMallocCounter::~FGamePhaseScopedMallocCounter()
+{
+	auto& CountingMalloc{ GetCountingMalloc() };
+	check(GMalloc == &CountingMalloc);
+
+	GMalloc = CountingMalloc.InnerMalloc;
+}
+
+int32 FGamePhaseScopedMallocCounter::GetNumAllocations() const
+{
+	return GetCountingMalloc().NumAllocations;
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////
+// FGamePhaseTestAccess
+
+#pragma region FGamePhaseTestAccess
+
+FActiveGamePhaseContainer& FGamePhaseTestAccess::GetContainer(UGamePhaseComponent* Component)
+{
+	return Component->ActiveGamePhases;
+}
+
+uint32 FGamePhaseTestAccess::GetSequenceNumber(const FActiveGamePhase& Entry)
+{
+	return Entry.SequenceNumber;
+}
+
+FActiveGamePhase FGamePhaseTestAccess::MakeReplicatedCopy(const FActiveGamePhase& Entry)
+{
+	FActiveGamePhase Copy;
+	Copy.ReplicationID = Entry.ReplicationID;
+	Copy.ReplicationKey = Entry.ReplicationKey;
+	Copy.ClassNetId = Entry.ClassNetId;
+	Copy.ParentClassNetId = Entry.ParentClassNetId;
+	Copy.FallbackClass = Entry.FallbackClass;
+	Copy.FallbackParentPhaseTag = Entry.FallbackParentPhaseTag;
+	Copy.ServerStartTime = Entry.ServerStartTime;
+	Copy.Duration = Entry.Duration;
+	Copy.ServerPauseTime = Entry.ServerPauseTime;
+	Copy.SequenceNumber = Entry.SequenceNumber;
+
+	return Copy;
+}
+
+void FGamePhaseTestAccess::ReceiveUpdate(UGamePhaseComponent* Client, const TArray<FActiveGamePhase>& Added, const TArray<int32>& RemovedReplicationIDs, const TArray<FActiveGamePhase>& Changed)
+{
+	auto& Container{ GetContainer(Client) };
+	const auto OldArraySize{ Container.Entries.Num() };
+
+	const auto FindIndex
+	{
+		[&Container](int32 ReplicationID)
+		{
+			return Container.Entries.IndexOfByPredicate(
+				[ReplicationID](const FActiveGamePhase& Entry)
+				{
+					return Entry.ReplicationID == ReplicationID;
+				}
+			);
+		}
+	};
+
+	// Removed
+
+	TArray<int32> RemovedIndices;
+
+	for (const auto& ReplicationID : RemovedReplicationIDs)
+	{
+		const auto Index{ FindIndex(ReplicationID) };
+
+		if (Index != INDEX_NONE)
+		{
+			RemovedIndices.Add(Index);
+		}
+	}
+
+	const auto FinalSize{ OldArraySize + Added.Num() - RemovedIndices.Num() };
+
+	if (!RemovedIndices.IsEmpty())
+	{
+		Container.PreReplicatedRemove(RemovedIndices, FinalSize);
+	}
+
+	// Added
+
+	TArray<int32> AddedIndices;
+
+	for (const auto& Entry : Added)
+	{
+		AddedIndices.Add(Container.Entries.Add(MakeReplicatedCopy(Entry)));
+	}
+
+	if (!AddedIndices.IsEmpty())
+	{
+		Container.PostReplicatedAdd(AddedIndices, FinalSize);
+	}
+
+	// Changed
+
+	TArray<int32> ChangedIndices;
+
+	for (const auto& Entry : Changed)
+	{
+		const auto Index{ FindIndex(Entry.ReplicationID) };
+
+		if (Index != INDEX_NONE)
+		{
+			auto& ClientEntry{ Container.Entries[Index] };
+			ClientEntry.ReplicationKey = Entry.ReplicationKey;
+			ClientEntry.ServerStartTime = Entry.ServerStartTime;
+			ClientEntry.Duration = Entry.Duration;
+			ClientEntry.ServerPauseTime = Entry.ServerPauseTime;
+
+			ChangedIndices.Add(Index);
+		}
+	}
+
+	if (!ChangedIndices.IsEmpty())
+	{
+		Container.PostReplicatedChange(ChangedIndices, FinalSize);
+	}
+
+	// The serializer removes in descending order of index by swapping
+
+	RemovedIndices.Sort(TGreater<int32>());
+
+	for (const auto& Index : RemovedIndices)
+	{
+		Container.Entries.RemoveAtSwap(Index);
+	}
+
+	FFastArraySerializer::FPostReplicatedReceiveParameters Parameters;
+	Parameters.OldArraySize = OldArraySize;
+	Parameters.bHasMoreUnmappedReferences = false;
+
+	Container.PostReplicatedReceive(Parameters);
+}
+
+void FGamePhaseTestAccess::ReplicateAll(UGamePhaseComponent* Server, UGamePhaseComponent* Client)
+{
+	const auto& ServerEntries{ GetContainer(Server).Entries };
+	const auto& ClientEntries{ GetContainer(Client).Entries };
+
+	TArray<FActiveGamePhase> Added;
+	TArray<FActiveGamePhase> Changed;
+	TArray<int32> RemovedReplicationIDs;
+
+	for (const auto& ServerEntry : ServerEntries)
+	{
+		// The client stands in for a connection without a player
+
+		if (ServerEntry.bServerOnly || ServerEntry.bRelevantPlayersOnly)
+		{
+			continue;
+		}
+
+		const auto* ClientEntry
+		{
+			ClientEntries.FindByPredicate(
+				[&ServerEntry](const FActiveGamePhase& Entry)
+				{
+					return Entry.ReplicationID == ServerEntry.ReplicationID;
+				}
+			)
+		};
+
+		if (!ClientEntry)
+		{
+			Added.Add(MakeReplicatedCopy(ServerEntry));
+		}
+		else if (ClientEntry->ReplicationKey != ServerEntry.ReplicationKey)
+		{
+			Changed.Add(MakeReplicatedCopy(ServerEntry));
+		}
+	}
+
+	for (const auto& ClientEntry : ClientEntries)
+	{
+		const auto bOnServer
+		{
+			ServerEntries.ContainsByPredicate(
+				[&ClientEntry](const FActiveGamePhase& Entry)
+				{
+					return Entry.ReplicationID == ClientEntry.ReplicationID;
+				}
+			)
+		};
+
+		if (!bOnServer)
+		{
+			RemovedReplicationIDs.Add(ClientEntry.ReplicationID);
+		}
+	}
+
+	ReceiveUpdate(Client, Added, RemovedReplicationIDs, Changed);
+}
+
+FActiveGamePhase FGamePhaseTestAccess::FindReplicatedCopy(UGamePhaseComponent* Server, const FGameplayTag& GamePhaseTag)
+{
+	const auto* Entry
+	{
+		GetContainer(Server).Entries.FindByPredicate(
+			[&GamePhaseTag](const FActiveGamePhase& Each)
+			{
+				return Each.GamePhaseTag == GamePhaseTag;
+			}
+		)
+	};
+
+	check(Entry);
+
+	return MakeReplicatedCopy(*Entry);
+}
+
+FActiveGamePhase FGamePhaseTestAccess::FindReplicatedCopyByReference(UGamePhaseComponent* Server, const FGameplayTag& GamePhaseTag)
+{
+	const auto* Entry{ FindEntryByTag(Server, GamePhaseTag) };
+	check(Entry);
+
+	auto Copy{ MakeReplicatedCopy(*Entry) };
+	Copy.ClassNetId = UGamePhaseClassRegistry::InvalidNetId;
+	Copy.ParentClassNetId = UGamePhaseClassRegistry::InvalidNetId;
+	Copy.FallbackClass = Entry->Class;
+	Copy.FallbackParentPhaseTag = Entry->ParentPhaseTag;
+
+	return Copy;
+}
+
+FActiveGamePhase FGamePhaseTestAccess::FindReplicatedCopyByNetId(UGamePhaseComponent* Server, const FGameplayTag& GamePhaseTag)
+{
+	const auto* Entry{ FindEntryByTag(Server, GamePhaseTag) };
+	check(Entry);
+
+	auto Copy{ MakeReplicatedCopy(*Entry) };
+	Copy.ClassNetId = MAX_uint16;
+	Copy.ParentClassNetId = Entry->ParentPhaseTag.IsValid() ? MAX_uint16 : UGamePhaseClassRegistry::InvalidNetId;
+	Copy.FallbackClass = nullptr;
+	Copy.FallbackParentPhaseTag = FGameplayTag::EmptyTag;
+
+	return Copy;
+}
+
+bool FGamePhaseTestAccess::ShouldReplicateTo(UGamePhaseComponent* Server, const FGameplayTag& GamePhaseTag, const APlayerController* PlayerController)
+{
+	auto& Container{ GetContainer(Server) };
+
+	const auto* Entry{ FindEntryByTag(Server, GamePhaseTag) };
+	check(Entry);
+
+	TGuardValue<const APlayerController*> ReplicatingPlayerGuard(Container.ReplicatingPlayer, PlayerController);
+
+	return Container.ShouldWriteFastArrayItem<FActiveGamePhase, FActiveGamePhaseContainer>(*Entry, false);
+}
+
+int64 FGamePhaseTestAccess::GetSerializedBits(const FActiveGamePhase& Entry)
+{
+	auto* PackageMap{ NewObject<UGamePhaseTestPackageMap>() };
+	FNetBitWriter Writer(PackageMap, 0);
+
+	auto& MutableEntry{ const_cast<FActiveGamePhase&>(Entry) };
+
+	for (TFieldIterator<FProperty> It(FActiveGamePhase::StaticStruct()); It; ++It)
+	{
+		if (!It->HasAnyPropertyFlags(CPF_RepSkip))
+		{
+			It->NetSerializeItem(Writer, PackageMap, It->ContainerPtrToValuePtr<void>(&MutableEntry));
+		}
+	}
+
+	return Writer.GetNumBits();
+}
+
+const FActiveGamePhase* FGamePhaseTestAccess::FindEntryByTag(UGamePhaseComponent* Component, const FGameplayTag& GamePhaseTag)
+{
+	auto& Container{ GetContainer(Component) };
+	const auto Index{ Container.FindEntryIndexByTag(GamePhaseTag) };
+
+	return Container.Entries.IsValidIndex(Index) ? &Container.Entries[Index] : nullptr;
+}
+
+void FGamePhaseTestAccess::AddSubPhaseWithTag(UGamePhaseComponent* Component, const TSubclassOf<UGamePhase>& GamePhaseClass, const FGameplayTag& GamePhaseTag, const FGameplayTag& ParentPhaseTag)
+{
+	auto& Container{ GetContainer(Component) };
+
+	FActiveGamePhase NewEntry(GamePhaseClass, ParentPhaseTag);
+	NewEntry.GamePhaseTag = GamePhaseTag;
+
+	const auto NewIndex{ Container.AddEntry(MoveTemp(NewEntry)) };
+	Container.MarkEntryDirty(Container.Entries[NewIndex]);
+	Container.HandleGamePhaseAdd(Container.Entries[NewIndex]);
+}
+
+void FGamePhaseTestAccess::BroadcastGamePhaseEvent(UGamePhaseSubsystem* Subsystem, const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType)
+{
+	Subsystem->BroadcastGamePhaseEvent(GamePhaseTag, EventType);
+}
+
+SIZE_T FGamePhaseTestAccess::GetListenerAllocatedSize(const UGamePhaseSubsystem* Subsystem)
+{
+	SIZE_T Size{ 0 };
+
+	Size += Subsystem->Listeners.GetAllocatedSize();
+	Size += Subsystem->FreeListenerIndices.GetAllocatedSize();
+	Size += Subsystem->ListenerMap.GetAllocatedSize();
+	Size += Subsystem->DispatchMap.GetAllocatedSize();
+	Size += Subsystem->DispatchLists.GetAllocatedSize();
+	Size += Subsystem->PendingRemovalIndices.GetAllocatedSize();
+	Size += Subsystem->PendingInsertionIndices.GetAllocatedSize();
+
+	for (const auto& KVP : Subsystem->ListenerMap)
+	{
+		Size += KVP.Value.ListenerIndices.GetAllocatedSize();
+	}
+
+	for (const auto& KVP : Subsystem->DispatchMap)
+	{
+		Size += Subsystem->DispatchLists[KVP.Value].ListenerIndices.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+#pragma endregion
+
+#endif // WITH_DEV_AUTOMATION_TESTS
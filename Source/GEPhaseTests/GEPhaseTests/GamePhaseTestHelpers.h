@@ -0,0 +1,155 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Phase/ActiveGamePhase.h"
+#include "Type/GamePhaseListenerTypes.h"
+
+#include "NativeGameplayTags.h"
+
+class UWorld;
+class APlayerController;
+class AGameStateBase;
+class UGamePhaseComponent;
+class UGamePhaseSubsystem;
+
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_GamePhaseTest_RootA);
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_GamePhaseTest_RootB);
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_GamePhaseTest_SubA);
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_GamePhaseTest_SubB);
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_GamePhaseTest_PooledRootA);
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_GamePhaseTest_PooledRootB);
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_GamePhaseTest_PooledSub);
+UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_GamePhaseTest_RelevantSub);
+
+
+/**
+ * World with a game state and a game phase component for the automation tests
+ * 
+ * Tips:
+ *	Play is not begun, so the component does not go through the init state of the game framework.
+ *	A world without authority stands in for a client.
+ */
+struct FGamePhaseTestWorld
+{
+public:
+	explicit FGamePhaseTestWorld(bool bAuthority = true);
+	~FGamePhaseTestWorld();
+
+public:
+	UWorld* World{ nullptr };
+	AGameStateBase* GameState{ nullptr };
+	UGamePhaseComponent* Component{ nullptr };
+	UGamePhaseSubsystem* Subsystem{ nullptr };
+
+};
+
+
+/**
+ * Counts the allocations made by the calling thread while in scope
+ * 
+ * Tips:
+ *	GMalloc is replaced by a proxy that forwards to it, so allocations made by other threads are not counted.
+ *	Scopes must not be nested.
+ */
+struct FGamePhaseScopedMallocCounter
+{
+public:
+	FGamePhaseScopedMallocCounter();
+	~FGamePhaseScopedMallocCounter();
+
+	int32 GetNumAllocations() const;
+
+};
+
+
+/**
+ * Access to the internals of the game phase classes for the automation tests
+ */
+struct FGamePhaseTestAccess
+{
+public:
+	static FActiveGamePhaseContainer& GetContainer(UGamePhaseComponent* Component);
+
+	static uint32 GetSequenceNumber(const FActiveGamePhase& Entry);
+
+	/**
+	 * Returns the entry as a client receives it, with only the replicated properties set
+	 */
+	static FActiveGamePhase MakeReplicatedCopy(const FActiveGamePhase& Entry);
+
+	/**
+	 * Deliver an update to the client container in the same order as the fast array serializer
+	 * 
+	 * Tips:
+	 *	PreReplicatedRemove, PostReplicatedAdd and PostReplicatedChange are called before the removed entries are 
+	 *	removed by swapping, and PostReplicatedReceive after.
+	 */
+	static void ReceiveUpdate(
+		UGamePhaseComponent* Client
+		, const TArray<FActiveGamePhase>& Added
+		, const TArray<int32>& RemovedReplicationIDs
+		, const TArray<FActiveGamePhase>& Changed = TArray<FActiveGamePhase>());
+
+	/**
+	 * Deliver all differences between the server and the client containers as a single update
+	 */
+	static void ReplicateAll(UGamePhaseComponent* Server, UGamePhaseComponent* Client);
+
+	/**
+	 * Returns the replicated copy of the server entry of the game phase
+	 */
+	static FActiveGamePhase FindReplicatedCopy(UGamePhaseComponent* Server, const FGameplayTag& GamePhaseTag);
+
+	/**
+	 * Returns the replicated copy of the server entry of the game phase with its classes replicated by reference
+	 */
+	static FActiveGamePhase FindReplicatedCopyByReference(UGamePhaseComponent* Server, const FGameplayTag& GamePhaseTag);
+
+	/**
+	 * Returns the replicated copy of the server entry of the game phase with its classes replicated by net ID
+	 * 
+	 * Tips:
+	 *	The test game phases are not in the class registry, so the IDs are placeholders of the same size
+	 */
+	static FActiveGamePhase FindReplicatedCopyByNetId(UGamePhaseComponent* Server, const FGameplayTag& GamePhaseTag);
+
+	/**
+	 * Returns whether the server entry of the game phase is written to the connection of the player
+	 */
+	static bool ShouldReplicateTo(UGamePhaseComponent* Server, const FGameplayTag& GamePhaseTag, const APlayerController* PlayerController);
+
+	/**
+	 * Returns the number of bits written by the net serialization of the replicated properties of the entry
+	 */
+	static int64 GetSerializedBits(const FActiveGamePhase& Entry);
+
+	/**
+	 * Returns the entry of the game phase, found through the tag index of the container
+	 */
+	static const FActiveGamePhase* FindEntryByTag(UGamePhaseComponent* Component, const FGameplayTag& GamePhaseTag);
+
+	/**
+	 * Start a sub-phase of the class under a tag other than the tag of the class
+	 * 
+	 * Tips:
+	 *	Allows the tests to start as many sub-phases as they need from a single test class.
+	 */
+	static void AddSubPhaseWithTag(
+		UGamePhaseComponent* Component
+		, const TSubclassOf<UGamePhase>& GamePhaseClass
+		, const FGameplayTag& GamePhaseTag
+		, const FGameplayTag& ParentPhaseTag);
+
+	static void BroadcastGamePhaseEvent(UGamePhaseSubsystem* Subsystem, const FGameplayTag& GamePhaseTag, EGamePhaseEventType EventType);
+
+	/**
+	 * Returns the memory allocated by the listener and dispatch storage of the subsystem
+	 */
+	static SIZE_T GetListenerAllocatedSize(const UGamePhaseSubsystem* Subsystem);
+
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
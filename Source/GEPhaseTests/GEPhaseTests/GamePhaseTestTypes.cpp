@@ -0,0 +1,139 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseTestTypes.h"
+
+#include "GamePhaseTestHelpers.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GamePhaseTestTypes)
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+UE_DEFINE_GAMEPLAY_TAG(TAG_GamePhaseTest_RootA, "GamePhase.Test.RootA");
+UE_DEFINE_GAMEPLAY_TAG(TAG_GamePhaseTest_RootB, "GamePhase.Test.RootB");
+UE_DEFINE_GAMEPLAY_TAG(TAG_GamePhaseTest_SubA, "GamePhase.Test.SubA");
+UE_DEFINE_GAMEPLAY_TAG(TAG_GamePhaseTest_SubB, "GamePhase.Test.SubB");
+UE_DEFINE_GAMEPLAY_TAG(TAG_GamePhaseTest_PooledRootA, "GamePhase.Test.PooledRootA");
+UE_DEFINE_GAMEPLAY_TAG(TAG_GamePhaseTest_PooledRootB, "GamePhase.Test.PooledRootB");
+UE_DEFINE_GAMEPLAY_TAG(TAG_GamePhaseTest_PooledSub, "GamePhase.Test.PooledSub");
+UE_DEFINE_GAMEPLAY_TAG(TAG_GamePhaseTest_RelevantSub, "GamePhase.Test.RelevantSub");
+#endif
+
+
+UGamePhaseTest_RootA::UGamePhaseTest_RootA(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	GamePhaseTag = TAG_GamePhaseTest_RootA;
+#endif
+}
+
+UGamePhaseTest_RootB::UGamePhaseTest_RootB(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	GamePhaseTag = TAG_GamePhaseTest_RootB;
+#endif
+}
+
+UGamePhaseTest_SubA::UGamePhaseTest_SubA(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	GamePhaseTag = TAG_GamePhaseTest_SubA;
+#endif
+}
+
+UGamePhaseTest_SubB::UGamePhaseTest_SubB(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	GamePhaseTag = TAG_GamePhaseTest_SubB;
+#endif
+}
+
+
+UGamePhaseTest_PooledRootA::UGamePhaseTest_PooledRootA(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	GamePhaseTag = TAG_GamePhaseTest_PooledRootA;
+#endif
+	bPoolInstances = true;
+}
+
+UGamePhaseTest_PooledRootB::UGamePhaseTest_PooledRootB(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	GamePhaseTag = TAG_GamePhaseTest_PooledRootB;
+#endif
+	bPoolInstances = true;
+}
+
+UGamePhaseTest_PooledSub::UGamePhaseTest_PooledSub(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	GamePhaseTag = TAG_GamePhaseTest_PooledSub;
+#endif
+	bPoolInstances = true;
+}
+
+
+UGamePhaseTest_RelevantSub::UGamePhaseTest_RelevantSub(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	GamePhaseTag = TAG_GamePhaseTest_RelevantSub;
+#endif
+	ReplicationPolicy = EGamePhaseReplicationPolicy::RelevantPlayersOnly;
+}
+
+bool UGamePhaseTest_RelevantSub::IsRelevantToPlayer_Implementation(const APlayerController* PlayerController) const
+{
+	return PlayerController && (PlayerController == RelevantPlayer);
+}
+
+
+UGamePhaseTest_Task::UGamePhaseTest_Task(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+void UGamePhaseTest_Task::OnDestroy(bool bInOwnerFinished)
+{
+	// Start the next task before this one is deactivated
+
+	if (bInOwnerFinished && bSpawnOnOwnerEnded && !SpawnedTask)
+	{
+		if (auto* Owner{ TaskOwner.Get() })
+		{
+			SpawnedTask = NewTask<UGamePhaseTest_Task>(*Owner);
+			SpawnedTask->ReadyForActivation();
+		}
+	}
+
+	Super::OnDestroy(bInOwnerFinished);
+}
+
+
+UGamePhaseTestPackageMap::UGamePhaseTestPackageMap(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+bool UGamePhaseTestPackageMap::SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID)
+{
+	check(Ar.IsSaving());
+
+	auto Index{ Obj ? static_cast<uint32>(Obj->GetUniqueID()) + 1 : 0u };
+	Ar.SerializeIntPacked(Index);
+
+	if (Obj)
+	{
+		auto PathName{ Obj->GetPathName() };
+		Ar << PathName;
+	}
+
+	return true;
+}
@@ -0,0 +1,134 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Phase/GamePhase.h"
+
+#include "GameplayTask.h"
+#include "UObject/CoreNet.h"
+
+#include "GamePhaseTestTypes.generated.h"
+
+class APlayerController;
+
+
+/**
+ * Game phases used by the automation tests
+ * 
+ * Tips:
+ *	The game phase tags are only registered when the automation tests are compiled
+ */
+UCLASS(NotBlueprintable, NotBlueprintType, HideDropdown)
+class UGamePhaseTest_RootA : public UGamePhase
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_RootA(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+};
+
+UCLASS(NotBlueprintable, NotBlueprintType, HideDropdown)
+class UGamePhaseTest_RootB : public UGamePhase
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_RootB(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+};
+
+UCLASS(NotBlueprintable, NotBlueprintType, HideDropdown)
+class UGamePhaseTest_SubA : public UGamePhase
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_SubA(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+};
+
+UCLASS(NotBlueprintable, NotBlueprintType, HideDropdown)
+class UGamePhaseTest_SubB : public UGamePhase
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_SubB(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+};
+
+
+/**
+ * Game phases whose instances are pooled, used by the allocation tests
+ */
+UCLASS(NotBlueprintable, NotBlueprintType, HideDropdown)
+class UGamePhaseTest_PooledRootA : public UGamePhase
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_PooledRootA(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+};
+
+UCLASS(NotBlueprintable, NotBlueprintType, HideDropdown)
+class UGamePhaseTest_PooledRootB : public UGamePhase
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_PooledRootB(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+};
+
+UCLASS(NotBlueprintable, NotBlueprintType, HideDropdown)
+class UGamePhaseTest_PooledSub : public UGamePhase
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_PooledSub(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+};
+
+
+/**
+ * Game phase sent only to a single player, used by the replication tests
+ */
+UCLASS(NotBlueprintable, NotBlueprintType, HideDropdown)
+class UGamePhaseTest_RelevantSub : public UGamePhase
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_RelevantSub(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	UPROPERTY(Transient)
+	TObjectPtr<const APlayerController> RelevantPlayer{ nullptr };
+
+	virtual bool IsRelevantToPlayer_Implementation(const APlayerController* PlayerController) const override;
+};
+
+
+/**
+ * Gameplay task that can start another task of its owner when the owner ends it, used by the task tests
+ */
+UCLASS(HideDropdown)
+class UGamePhaseTest_Task : public UGameplayTask
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTest_Task(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	UPROPERTY(Transient)
+	TObjectPtr<UGamePhaseTest_Task> SpawnedTask{ nullptr };
+
+	bool bSpawnOnOwnerEnded{ false };
+
+protected:
+	virtual void OnDestroy(bool bInOwnerFinished) override;
+};
+
+
+/**
+ * Package map used by the automation tests to measure the size of replicated data
+ * 
+ * Tips:
+ *	References are written as a packed index followed by their path, as on the first send of a reference 
+ *	that the client has not acknowledged yet
+ */
+UCLASS(Transient)
+class UGamePhaseTestPackageMap : public UPackageMap
+{
+	GENERATED_BODY()
+public:
+	UGamePhaseTestPackageMap(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual bool SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID = nullptr) override;
+};
@@ -0,0 +1,74 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GamePhaseTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "GamePhaseTestTypes.h"
+#include "GamePhaseComponent.h"
+
+#include "GamePhaseSubsystem.h"
+
+#include "Misc/AutomationTest.h"
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGamePhaseTransactionHoldEventsTest, "GameExt.GamePhase.Transaction.HoldEvents", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FGamePhaseTransactionHoldEventsTest::RunTest(const FString& Parameters)
+{
+	FGamePhaseTestWorld TestWorld;
+	auto* Component{ TestWorld.Component };
+	auto* Subsystem{ TestWorld.Subsystem };
+
+	TestTrue(TEXT("Root phase set"), Component->SetGamePhase(UGamePhaseTest_RootA::StaticClass()));
+
+	// Record whether the later change was already applied when each event is received
+
+	TArray<FString> Calls;
+
+	Subsystem->RegisterListener(TAG_GamePhaseTest_SubA,
+		[&Calls, Subsystem](FGameplayTag, EGamePhaseEventType EventType)
+		{
+			Calls.Add(FString::Printf(TEXT("%s:SubA(SubB %s)")
+				, (EventType == EGamePhaseEventType::Start) ? TEXT("Start") : TEXT("End")
+				, Subsystem->IsGamePhaseActive(TAG_GamePhaseTest_SubB) ? TEXT("active") : TEXT("inactive")));
+		});
+
+	Subsystem->RegisterListener(TAG_GamePhaseTest_SubB,
+		[&Calls, Subsystem](FGameplayTag, EGamePhaseEventType EventType)
+		{
+			Calls.Add(FString::Printf(TEXT("%s:SubB(SubA %s)")
+				, (EventType == EGamePhaseEventType::Start) ? TEXT("Start") : TEXT("End")
+				, Subsystem->IsGamePhaseActive(TAG_GamePhaseTest_SubA) ? TEXT("active") : TEXT("inactive")));
+		});
+
+	// Start both sub-phases together
+
+	{
+		FGamePhaseTransaction Transaction{ Component };
+
+		TestTrue(TEXT("SubA recorded"), Component->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA));
+		TestTrue(TEXT("SubB recorded"), Component->AddSubPhase(UGamePhaseTest_SubB::StaticClass(), TAG_GamePhaseTest_RootA));
+
+		TestTrue(TEXT("Transaction applied"), Transaction.Commit());
+	}
+
+	TestEqual(TEXT("Started after all changes"), FString::Join(Calls, TEXT(",")), FString(TEXT("Start:SubA(SubB active),Start:SubB(SubA active)")));
+
+	// Replace one sub-phase with the other
+
+	Calls.Reset();
+
+	{
+		FGamePhaseTransaction Transaction{ Component };
+
+		TestTrue(TEXT("SubA end recorded"), Component->EndPhaseByTag(TAG_GamePhaseTest_SubA));
+		TestTrue(TEXT("SubB end recorded"), Component->EndPhaseByTag(TAG_GamePhaseTest_SubB));
+		TestTrue(TEXT("SubA start recorded"), Component->AddSubPhase(UGamePhaseTest_SubA::StaticClass(), TAG_GamePhaseTest_RootA));
+	}
+
+	TestEqual(TEXT("Ended and started after all changes"), FString::Join(Calls, TEXT(",")), FString(TEXT("End:SubA(SubB inactive),End:SubB(SubA active),Start:SubA(SubB inactive)")));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS